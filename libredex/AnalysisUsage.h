@@ -40,6 +40,8 @@ class AnalysisUsage {
     m_preserve_all = preserve_all;
   }
 
+  bool preserves_all() const { return m_preserve_all; }
+
   // A required pass is used by (thus should precede) this current pass.
   template <typename AnalysisPassType>
   void add_required() {
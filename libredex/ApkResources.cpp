@@ -286,23 +286,26 @@ TableSnapshot::TableSnapshot(RedexMappedFile& mapped_file, size_t len) {
                                      : mapped_file.data();
   always_assert_log(m_table_parser.visit(data, len),
                     "Failed to parse .arsc file");
+  // String pools refer to the mapped file directly rather than copying it, the
+  // global pool alone can be tens of megabytes. This is fine as the snapshot
+  // never outlives the mapping it was built from (see mark_file_closed()).
   always_assert_log(
       m_global_strings.setTo(m_table_parser.m_global_pool_header,
                              CHUNK_SIZE(m_table_parser.m_global_pool_header),
-                             true) == android::NO_ERROR,
+                             false) == android::NO_ERROR,
       "Failed to parse global strings!");
   for (const auto& pair : m_table_parser.m_package_key_string_headers) {
     auto package_id = GET_ID(pair.first);
     always_assert_log(
         m_key_strings[package_id].setTo(pair.second, CHUNK_SIZE(pair.second),
-                                        true) == android::NO_ERROR,
+                                        false) == android::NO_ERROR,
         "Failed to parse key strings for package 0x%x", package_id);
   }
   for (const auto& pair : m_table_parser.m_package_type_string_headers) {
     auto package_id = GET_ID(pair.first);
     always_assert_log(
         m_type_strings[package_id].setTo(pair.second, CHUNK_SIZE(pair.second),
-                                         true) == android::NO_ERROR,
+                                         false) == android::NO_ERROR,
         "Failed to parse type strings for package 0x%x", package_id);
   }
 }
@@ -1711,7 +1714,7 @@ void ResourcesArscFile::remap_reorder_and_serialize(
     const std::vector<std::string>& /* resource_files */,
     const std::map<uint32_t, uint32_t>& old_to_new) {
   remap_ids(old_to_new);
-  apk::TableEntryParser table_parser = get_table_snapshot().get_parsed_table();
+  auto& table_parser = get_table_snapshot().get_parsed_table();
   arsc::ResTableBuilder table_builder;
   table_builder.set_global_strings(table_parser.m_global_pool_header);
   for (const auto& package : table_parser.m_packages) {
@@ -1775,8 +1778,8 @@ void ResourcesArscFile::remap_reorder_and_serialize(
   }
   android::Vector<char> out;
   table_builder.serialize(&out);
-  m_arsc_len = write_serialized_data(out, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data(out, std::move(m_f));
 }
 
 namespace {
@@ -2225,8 +2228,8 @@ void ResourcesArscFile::finalize_resource_table(const ResourceConfig& config) {
   // 6) Actually write the table to disk so changes take effect.
   TRACE(RES, 9, "Writing resources.arsc file, total size = %zu",
         serialized.size());
-  m_arsc_len = write_serialized_data(serialized, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data(serialized, std::move(m_f));
 }
 
 namespace {
@@ -2427,8 +2430,8 @@ size_t ResourcesArscFile::obfuscate_resource_and_serialize(
   // 3) Actually write the table to disk so changes take effect.
   TRACE(RES, 9, "Writing resources.arsc file, total size = %zu",
         serialized.size());
-  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   return changed_resource_name;
 }
 
@@ -2611,7 +2614,7 @@ size_t ResourcesArscFile::serialize() {
   // file. To do this, forward chunks from the parsed file to ResTableBuilder
   // and let that class make sense of what is to be omitted/retained in the
   // serialized output.
-  apk::TableEntryParser table_parser = get_table_snapshot().get_parsed_table();
+  auto& table_parser = get_table_snapshot().get_parsed_table();
   // Re-assemble
   arsc::ResTableBuilder table_builder;
   table_builder.set_global_strings(table_parser.m_global_pool_header);
@@ -2684,8 +2687,8 @@ size_t ResourcesArscFile::serialize() {
   android::Vector<char> serialized;
   table_builder.serialize(&serialized);
 
-  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   return m_arsc_len;
 }
 
@@ -3177,8 +3180,8 @@ void ResourcesArscFile::modify_attributes(
   android::Vector<char> serialized;
   table_builder.serialize(&serialized);
 
-  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
 }
 
 void ResourcesArscFile::apply_attribute_removals_and_additions(
@@ -3442,8 +3445,8 @@ void ResourcesArscFile::add_styles(
   android::Vector<char> serialized;
   table_builder.serialize(&serialized);
 
-  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
   mark_file_closed();
+  m_arsc_len = write_serialized_data_with_expansion(serialized, std::move(m_f));
 }
 
 ResourcesArscFile::~ResourcesArscFile() {}
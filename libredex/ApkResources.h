@@ -391,6 +391,8 @@ class ResourcesArscFile : public ResourceTableFile {
   apk::TableSnapshot& get_table_snapshot();
 
  private:
+  // Drops the table snapshot, which points into the mapped file. Must be called
+  // before m_f gets unmapped or rewritten.
   void mark_file_closed();
   void modify_attributes(
       const resources::ResourceAttributeMap& resource_id_to_mod_attribute,
@@ -12,6 +12,7 @@
 #ifdef HAS_PROTOBUF
 #include "BundleResources.h"
 
+#include <chrono>
 #include <fstream>
 #include <map>
 #include <queue>
@@ -21,6 +22,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/message.h>
@@ -33,6 +35,7 @@
 #include "ReadMaybeMapped.h"
 #include "RedexResources.h"
 #include "Trace.h"
+#include "WorkQueue.h"
 #include "androidfw/LocaleValue.h"
 #include "androidfw/ResourceTypes.h"
 #include "utils/Serialize.h"
@@ -65,6 +68,42 @@ void read_protobuf_file_contents(
   });
 }
 
+// Parses each of the given resources.pb files (one per module), applies the
+// given transform and writes the table back. Modules are independent of each
+// other and are handled in parallel. Messages are allocated on a per-module
+// arena, which makes building and tearing down large tables much cheaper.
+void transform_resource_tables_and_serialize(
+    const std::vector<std::string>& resource_files,
+    const char* description,
+    const std::function<void(aapt::pb::ResourceTable*)>& transform) {
+  workqueue_run<std::string>(
+      [&](const std::string& resources_pb_path) {
+        TRACE(RES, 9, "BundleResources %s for file: %s", description,
+              resources_pb_path.c_str());
+        auto start = std::chrono::steady_clock::now();
+        read_protobuf_file_contents(
+            resources_pb_path,
+            [&](google::protobuf::io::CodedInputStream& input,
+                size_t /* unused */) {
+              google::protobuf::Arena arena;
+              auto* pb_restable = google::protobuf::Arena::CreateMessage<
+                  aapt::pb::ResourceTable>(&arena);
+              bool read_finish = pb_restable->ParseFromCodedStream(&input);
+              always_assert_log(read_finish,
+                                "BundleResource failed to read %s",
+                                resources_pb_path.c_str());
+              transform(pb_restable);
+              std::ofstream out(resources_pb_path, std::ofstream::binary);
+              always_assert(pb_restable->SerializeToOstream(&out));
+            });
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        TRACE(RES, 2, "BundleResources %s for file %s took %.3fs", description,
+              resources_pb_path.c_str(), elapsed.count());
+      },
+      resource_files);
+}
+
 bool has_attribute(const aapt::pb::XmlElement& element,
                    const std::string& name) {
   for (const aapt::pb::XmlAttribute& pb_attr : element.attribute()) {
@@ -1468,113 +1507,83 @@ UnorderedSet<uint32_t> BundleResources::get_xml_reference_attributes(
 void ResourcesPbFile::remap_res_ids_and_serialize(
     const std::vector<std::string>& resource_files,
     const std::map<uint32_t, uint32_t>& old_to_new) {
-  for (const auto& resources_pb_path : resource_files) {
-    TRACE(RES,
-          9,
-          "BundleResources changing resource data for file: %s",
-          resources_pb_path.c_str());
-    read_protobuf_file_contents(
-        resources_pb_path,
-        [&](google::protobuf::io::CodedInputStream& input,
-            size_t /* unused */) {
-          aapt::pb::ResourceTable pb_restable;
-          bool read_finish = pb_restable.ParseFromCodedStream(&input);
-          always_assert_log(read_finish,
-                            "BundleResource failed to read %s",
-                            resources_pb_path.c_str());
-          int package_size = pb_restable.package_size();
-          for (int i = 0; i < package_size; i++) {
-            auto* package = pb_restable.mutable_package(i);
-            auto current_package_id = package->package_id().id();
-            int original_type_size = package->type_size();
-            // Apply newly added types. Source res ids must have their data
-            // remapped, according to the given map, which we will do based off
-            // of the cached "ConfigValues" map.
-            for (auto& type_def : m_added_types) {
-              if (type_def.package_id == current_package_id) {
-                TRACE(RES, 9, "Appending type %s (ID 0x%x) to package 0x%x",
-                      type_def.name.c_str(), type_def.type_id,
-                      type_def.package_id);
-                auto* new_type = package->add_type();
-                new_type->set_name(type_def.name);
-                new_type->mutable_type_id()->set_id(type_def.type_id);
-
-                google::protobuf::RepeatedPtrField<aapt::pb::Entry> new_entries;
-                size_t current_entry_id = 0;
-                for (const auto& source_id : type_def.source_res_ids) {
-                  auto& source_name = id_to_name.at(source_id);
-                  const auto& source_config_values =
-                      m_internals->m_res_id_to_configvalue.at(source_id);
-
-                  auto source_entry = std::make_shared<aapt::pb::Entry>();
-                  // Entry id needs to really just be the entry id, i.e. YYYY
-                  // from 0x7fXXYYYY
-                  source_entry->mutable_entry_id()->set_id(source_id & 0xFFFF);
-                  source_entry->set_name(source_name);
-                  source_entry->set_allocated_visibility(
-                      new aapt::pb::Visibility(
-                          m_internals->m_res_id_to_entry.at(source_id)
-                              .visibility()));
-                  for (const auto& source_cv : source_config_values) {
-                    auto* new_config_value = source_entry->add_config_value();
-                    new_config_value->set_allocated_config(
-                        new aapt::pb::Configuration(source_cv.config()));
-                    new_config_value->set_allocated_value(
-                        new aapt::pb::Value(source_cv.value()));
-                  }
-                  auto* remapped_entry =
-                      new_remapped_entry(*source_entry, source_id, old_to_new);
-                  remapped_entry->mutable_entry_id()->set_id(
-                      static_cast<uint32_t>(current_entry_id++));
-                  new_entries.AddAllocated(remapped_entry);
+  transform_resource_tables_and_serialize(
+      resource_files, "changing resource data",
+      [&](aapt::pb::ResourceTable* pb_restable) {
+        int package_size = pb_restable->package_size();
+        for (int i = 0; i < package_size; i++) {
+          auto* package = pb_restable->mutable_package(i);
+          auto current_package_id = package->package_id().id();
+          int original_type_size = package->type_size();
+          // Apply newly added types. Source res ids must have their data
+          // remapped, according to the given map, which we will do based off
+          // of the cached "ConfigValues" map.
+          for (auto& type_def : m_added_types) {
+            if (type_def.package_id == current_package_id) {
+              TRACE(RES, 9, "Appending type %s (ID 0x%x) to package 0x%x",
+                    type_def.name.c_str(), type_def.type_id,
+                    type_def.package_id);
+              auto* new_type = package->add_type();
+              new_type->set_name(type_def.name);
+              new_type->mutable_type_id()->set_id(type_def.type_id);
+
+              google::protobuf::RepeatedPtrField<aapt::pb::Entry> new_entries;
+              size_t current_entry_id = 0;
+              for (const auto& source_id : type_def.source_res_ids) {
+                auto& source_name = id_to_name.at(source_id);
+                const auto& source_config_values =
+                    m_internals->m_res_id_to_configvalue.at(source_id);
+
+                auto source_entry = std::make_shared<aapt::pb::Entry>();
+                // Entry id needs to really just be the entry id, i.e. YYYY
+                // from 0x7fXXYYYY
+                source_entry->mutable_entry_id()->set_id(source_id & 0xFFFF);
+                source_entry->set_name(source_name);
+                source_entry->set_allocated_visibility(new aapt::pb::Visibility(
+                    m_internals->m_res_id_to_entry.at(source_id).visibility()));
+                for (const auto& source_cv : source_config_values) {
+                  auto* new_config_value = source_entry->add_config_value();
+                  new_config_value->set_allocated_config(
+                      new aapt::pb::Configuration(source_cv.config()));
+                  new_config_value->set_allocated_value(
+                      new aapt::pb::Value(source_cv.value()));
                 }
-                new_type->clear_entry();
-                new_type->mutable_entry()->Swap(&new_entries);
+                auto* remapped_entry =
+                    new_remapped_entry(*source_entry, source_id, old_to_new);
+                remapped_entry->mutable_entry_id()->set_id(
+                    static_cast<uint32_t>(current_entry_id++));
+                new_entries.AddAllocated(remapped_entry);
               }
-            }
-            // Remap and apply deletions for the original types in the table.
-            for (int j = 0; j < original_type_size; j++) {
-              auto* type = package->mutable_type(j);
-              remove_or_change_resource_ids(m_ids_to_remove, old_to_new,
-                                            current_package_id, type);
+              new_type->clear_entry();
+              new_type->mutable_entry()->Swap(&new_entries);
             }
           }
-          std::ofstream out(resources_pb_path, std::ofstream::binary);
-          always_assert(pb_restable.SerializeToOstream(&out));
-        });
-  }
+          // Remap and apply deletions for the original types in the table.
+          for (int j = 0; j < original_type_size; j++) {
+            auto* type = package->mutable_type(j);
+            remove_or_change_resource_ids(m_ids_to_remove, old_to_new,
+                                          current_package_id, type);
+          }
+        }
+      });
 }
 
 void ResourcesPbFile::nullify_res_ids_and_serialize(
     const std::vector<std::string>& resource_files) {
-  for (const auto& resources_pb_path : resource_files) {
-    TRACE(RES,
-          9,
-          "BundleResources changing resource data for file: %s",
-          resources_pb_path.c_str());
-    read_protobuf_file_contents(
-        resources_pb_path,
-        [&](google::protobuf::io::CodedInputStream& input,
-            size_t /* unused */) {
-          aapt::pb::ResourceTable pb_restable;
-          bool read_finish = pb_restable.ParseFromCodedStream(&input);
-          always_assert_log(read_finish,
-                            "BundleResource failed to read %s",
-                            resources_pb_path.c_str());
-          int package_size = pb_restable.package_size();
-          for (int i = 0; i < package_size; i++) {
-            auto* package = pb_restable.mutable_package(i);
-            auto current_package_id = package->package_id().id();
-            int type_size = package->type_size();
-            for (int j = 0; j < type_size; j++) {
-              auto* type = package->mutable_type(j);
-              nullify_resource_ids(m_ids_to_remove, current_package_id, type);
-            }
+  transform_resource_tables_and_serialize(
+      resource_files, "changing resource data",
+      [&](aapt::pb::ResourceTable* pb_restable) {
+        int package_size = pb_restable->package_size();
+        for (int i = 0; i < package_size; i++) {
+          auto* package = pb_restable->mutable_package(i);
+          auto current_package_id = package->package_id().id();
+          int type_size = package->type_size();
+          for (int j = 0; j < type_size; j++) {
+            auto* type = package->mutable_type(j);
+            nullify_resource_ids(m_ids_to_remove, current_package_id, type);
           }
-          std::ofstream out(resources_pb_path, std::ofstream::binary);
-          always_assert(pb_restable.SerializeToOstream(&out));
-        });
-  }
+        }
+      });
 }
 
 void ResourcesPbFile::remap_reorder_and_serialize(
@@ -1615,42 +1624,27 @@ void ResourcesPbFile::remap_file_paths_and_serialize(
       file->set_path(search->second);
     }
   };
-  for (const auto& resources_pb_path : resource_files) {
-    TRACE(RES,
-          9,
-          "BundleResources changing file paths for file: %s",
-          resources_pb_path.c_str());
-    read_protobuf_file_contents(
-        resources_pb_path,
-        [&](google::protobuf::io::CodedInputStream& input,
-            size_t /* unused */) {
-          aapt::pb::ResourceTable pb_restable;
-          bool read_finish = pb_restable.ParseFromCodedStream(&input);
-          always_assert_log(read_finish,
-                            "BundleResource failed to read %s",
-                            resources_pb_path.c_str());
-          int package_size = pb_restable.package_size();
-          for (int i = 0; i < package_size; i++) {
-            auto* package = pb_restable.mutable_package(i);
-            auto current_package_id = package->package_id().id();
-            int type_size = package->type_size();
-            for (int j = 0; j < type_size; j++) {
-              auto* type = package->mutable_type(j);
-              auto current_type_id = type->type_id().id();
-              int entry_size = type->entry_size();
-              for (int k = 0; k < entry_size; k++) {
-                auto* entry = type->mutable_entry(k);
-                uint32_t res_id =
-                    MAKE_RES_ID(current_package_id, current_type_id,
-                                entry->entry_id().id());
-                remap_entry_file_paths(remap_filepaths, res_id, entry);
-              }
+  transform_resource_tables_and_serialize(
+      resource_files, "changing file paths",
+      [&](aapt::pb::ResourceTable* pb_restable) {
+        int package_size = pb_restable->package_size();
+        for (int i = 0; i < package_size; i++) {
+          auto* package = pb_restable->mutable_package(i);
+          auto current_package_id = package->package_id().id();
+          int type_size = package->type_size();
+          for (int j = 0; j < type_size; j++) {
+            auto* type = package->mutable_type(j);
+            auto current_type_id = type->type_id().id();
+            int entry_size = type->entry_size();
+            for (int k = 0; k < entry_size; k++) {
+              auto* entry = type->mutable_entry(k);
+              uint32_t res_id = MAKE_RES_ID(current_package_id, current_type_id,
+                                            entry->entry_id().id());
+              remap_entry_file_paths(remap_filepaths, res_id, entry);
             }
           }
-          std::ofstream out(resources_pb_path, std::ofstream::binary);
-          always_assert(pb_restable.SerializeToOstream(&out));
-        });
-  }
+        }
+      });
 }
 
 bool find_prefix_match(const UnorderedSet<std::string>& prefixes,
@@ -2404,9 +2398,11 @@ void BundleResources::obfuscate_xml_files(
       }
     }
   }
-  for (const auto& path : xml_paths) {
-    obfuscate_xml_attributes(path, do_not_obfuscate_elements);
-  }
+  workqueue_run<std::string>(
+      [&](const std::string& path) {
+        obfuscate_xml_attributes(path, do_not_obfuscate_elements);
+      },
+      xml_paths);
 }
 
 void BundleResources::finalize_bundle_config(const ResourceConfig& config) {
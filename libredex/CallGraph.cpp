@@ -7,6 +7,7 @@
 
 #include "CallGraph.h"
 
+#include <atomic>
 #include <utility>
 
 #include "ConcurrentContainers.h"
@@ -381,29 +382,9 @@ Graph::Graph(const BuildStrategy& strat)
   UnorderedBag<Node*> root_nodes;
 
   // Obtain the callsites of each method recursively, building the graph in the
-  // process.
-  ConcurrentMap<NodeId, std::list<std::vector<const Edge*>>> concurrent_preds;
-  std::mutex predecessors_wq_mutex;
-  auto predecessors_wq = workqueue_foreach<Node*>([&](Node* callee_node) {
-    auto& preds = concurrent_preds.at_unsafe(callee_node);
-    std::vector<std::vector<const Edge*>> callee_edges;
-    callee_edges.reserve(preds.size());
-    size_t size = 0;
-    for (auto& edges : preds) {
-      size += edges.size();
-      callee_edges.emplace_back(std::move(edges));
-    }
-    std::sort(callee_edges.begin(), callee_edges.end(), [](auto& p, auto& q) {
-      return compare_dexmethods(p.front()->caller()->method(),
-                                q.front()->caller()->method());
-    });
-    auto& callee_predecessors = callee_node->m_predecessors;
-    callee_predecessors.reserve(size);
-    for (auto& edges : callee_edges) {
-      callee_predecessors.insert(callee_predecessors.end(), edges.begin(),
-                                 edges.end());
-    }
-  });
+  // process. The ghost entry and exit nodes have ids 0 and 1.
+  m_exit->m_id = 1;
+  std::atomic<uint32_t> next_id{2};
 
   struct WorkItem {
     const DexMethod* caller;
@@ -418,6 +399,7 @@ Graph::Graph(const BuildStrategy& strat)
               m_nodes.get_or_emplace_and_assert_equal(method, method);
           Node* node = const_cast<Node*>(const_node);
           if (node_created) {
+            node->m_id = next_id.fetch_add(1);
             worker_state->push_task((WorkItem){method, node});
           }
           return node;
@@ -480,31 +462,10 @@ Graph::Graph(const BuildStrategy& strat)
                     return compare_dexmethods(p.callee_node->method(),
                                               q.callee_node->method());
                   });
-        std::vector<Node*> added_preds;
         for (auto&& [callee_node, callee_invoke_insns] : callee_partitions) {
-          std::vector<const Edge*> callee_edges;
-          callee_edges.reserve(callee_invoke_insns.size());
           for (auto* invoke_insn : callee_invoke_insns) {
             caller_successors.emplace_back(caller_node, callee_node,
                                            invoke_insn);
-            callee_edges.push_back(&caller_successors.back());
-          }
-          bool preds_added;
-          concurrent_preds.update(callee_node,
-                                  [&](auto, auto& preds, bool exists) {
-                                    preds_added = !exists;
-                                    preds.emplace_back(std::move(callee_edges));
-                                  });
-          if (preds_added) {
-            added_preds.push_back(callee_node);
-          }
-        }
-
-        // Schedule postprocessing of predecessors of newly-added preds.
-        if (!added_preds.empty()) {
-          std::lock_guard<std::mutex> lock_guard(predecessors_wq_mutex);
-          for (auto* node : added_preds) {
-            predecessors_wq.add_item(node);
           }
         }
 
@@ -522,11 +483,58 @@ Graph::Graph(const BuildStrategy& strat)
   for (const DexMethod* root : UnorderedIterable(root_and_dynamic.roots)) {
     auto [root_node, emplaced] = m_nodes.emplace_unsafe(root, root);
     always_assert(emplaced);
+    root_node->m_id = next_id.fetch_add(1);
     successors_wq.add_item((WorkItem){root, root_node});
     root_nodes.insert(root_node);
   }
   successors_wq.run_all();
-  predecessors_wq.run_all();
+
+  // Gather the predecessors of all nodes into m_predecessors without locking:
+  // count the predecessors of each node, reserve a contiguous range for each
+  // node, let the callers claim slots in the ranges of their callees in
+  // parallel, and finally sort each range.
+  m_num_nodes = next_id.load();
+  std::vector<Node*> nodes(m_num_nodes);
+  nodes[0] = m_entry.get();
+  nodes[1] = m_exit.get();
+  for (auto& [_, node] : UnorderedIterable(m_nodes)) {
+    nodes[node.m_id] = const_cast<Node*>(&node);
+  }
+  std::vector<std::atomic<uint32_t>> slots(m_num_nodes);
+  workqueue_run_for<size_t>(0, m_num_nodes, [&](size_t id) {
+    for (const auto& edge : nodes[id]->m_successors) {
+      slots[edge.callee()->m_id].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+  std::vector<uint32_t> offsets(m_num_nodes + 1);
+  for (size_t id = 0; id < m_num_nodes; ++id) {
+    auto count = slots[id].load(std::memory_order_relaxed);
+    offsets[id + 1] = offsets[id] + count;
+    slots[id].store(offsets[id], std::memory_order_relaxed);
+  }
+  m_predecessors.resize(offsets[m_num_nodes]);
+  workqueue_run_for<size_t>(0, m_num_nodes, [&](size_t id) {
+    for (const auto& edge : nodes[id]->m_successors) {
+      auto slot =
+          slots[edge.callee()->m_id].fetch_add(1, std::memory_order_relaxed);
+      m_predecessors[slot] = &edge;
+    }
+  });
+  workqueue_run_for<size_t>(0, m_num_nodes, [&](size_t id) {
+    auto begin = m_predecessors.begin() + offsets[id];
+    auto end = m_predecessors.begin() + offsets[id + 1];
+    // The edges of a caller are contiguous in its m_successors, so ordering
+    // the edges of a caller by address keeps their order.
+    std::sort(begin, end, [](const Edge* e1, const Edge* e2) {
+      if (e1->caller() != e2->caller()) {
+        return compare_dexmethods(e1->caller()->method(),
+                                  e2->caller()->method());
+      }
+      return e1 < e2;
+    });
+    nodes[id]->m_predecessors = std::span<const Edge* const>(
+        m_predecessors.data() + offsets[id], offsets[id + 1] - offsets[id]);
+  });
 }
 
 const MethodSet& resolve_callees_in_graph(const Graph& graph,
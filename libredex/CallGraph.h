@@ -8,6 +8,7 @@
 #pragma once
 
 #include <queue>
+#include <span>
 
 #include <sparta/MonotonicFixpointIterator.h>
 
@@ -161,9 +162,16 @@ class Node final {
   explicit Node(NodeType type) : m_method(nullptr), m_type(type) {}
 
   const DexMethod* method() const { return m_method; }
-  const std::vector<const Edge*>& callers() const { return m_predecessors; }
+  // The reverse edges, i.e., the edges whose callee is this node. They are
+  // sorted by caller method, and the edges of a caller are in the same order
+  // as in its callees().
+  std::span<const Edge* const> callers() const { return m_predecessors; }
   EdgesAdapter callees() const { return EdgesAdapter(&m_successors); }
 
+  // A dense id in [0, Graph::num_nodes()). The ghost entry and exit nodes have
+  // ids 0 and 1.
+  uint32_t id() const { return m_id; }
+
   bool is_entry() const { return m_type == GHOST_ENTRY; }
   bool is_exit() const { return m_type == GHOST_EXIT; }
 
@@ -173,9 +181,11 @@ class Node final {
 
  private:
   const DexMethod* m_method;
-  std::vector<const Edge*> m_predecessors;
+  // A range of Graph::m_predecessors.
+  std::span<const Edge* const> m_predecessors;
   std::vector<Edge> m_successors;
   NodeType m_type;
+  uint32_t m_id{0};
 
   friend class Graph;
 };
@@ -199,6 +209,9 @@ class Graph final {
   NodeId entry() const { return m_entry.get(); }
   NodeId exit() const { return m_exit.get(); }
 
+  // The number of nodes, including the ghost entry and exit nodes.
+  size_t num_nodes() const { return m_num_nodes; }
+
   bool has_node(const DexMethod* m) const {
     return m_nodes.count_unsafe(m) != 0;
   }
@@ -252,6 +265,9 @@ class Graph final {
   std::unique_ptr<Node> m_entry;
   std::unique_ptr<Node> m_exit;
   InsertOnlyConcurrentMap<const DexMethod*, Node> m_nodes;
+  size_t m_num_nodes{0};
+  // The predecessor edges of all nodes, grouped by callee.
+  std::vector<const Edge*> m_predecessors;
   InsertOnlyConcurrentMap<const IRInstruction*, UnorderedSet<const DexMethod*>>
       m_insn_to_callee;
   mutable InsertOnlyConcurrentMap<const DexMethod*, MethodBag>
@@ -337,8 +353,8 @@ class GraphInterface {
 
   static NodeId entry(const Graph& graph) { return graph.entry(); }
   static NodeId exit(const Graph& graph) { return graph.exit(); }
-  static const std::vector<const Edge*>& predecessors(const Graph&,
-                                                      const NodeId& m) {
+  static std::span<const Edge* const> predecessors(const Graph&,
+                                                   const NodeId& m) {
     return m->callers();
   }
   static EdgesAdapter successors(const Graph&, const NodeId& m) {
@@ -7,13 +7,27 @@
 
 #include "ChromeTraceWriter.h"
 
+#include <algorithm>
 #include <array>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
 
+#include "DeterministicContainers.h"
+
 // Zero-initialized at startup, no constructor needed.
 std::atomic<ChromeTraceWriter::State*> ChromeTraceWriter::s_enabled{nullptr};
+std::atomic<int64_t> ChromeTraceWriter::s_work_item_threshold_ns{0};
+
+struct ChromeTraceWriter::ThreadBuffer {
+  // Only contended while events are being written out or discarded.
+  std::mutex lock;
+  // A deque, so that references stay valid while the thread records more.
+  std::deque<std::string> names;
+  UnorderedMap<std::string, uint32_t> name_ids;
+  std::vector<Event> events;
+};
 
 ChromeTraceWriter::State& ChromeTraceWriter::get_state() {
   // Intentionally leaked – must outlive every static destructor so that
@@ -22,6 +36,20 @@ ChromeTraceWriter::State& ChromeTraceWriter::get_state() {
   return *state;
 }
 
+ChromeTraceWriter::ThreadBuffer& ChromeTraceWriter::get_thread_buffer(
+    State& s) {
+  // Buffers are leaked along with the state, so the pointer stays valid even
+  // after the thread is gone and its events have not been written yet.
+  thread_local ThreadBuffer* t_buffer = nullptr;
+  if (t_buffer == nullptr) {
+    auto* buffer = new ThreadBuffer();
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.buffers.push_back(buffer);
+    t_buffer = buffer;
+  }
+  return *t_buffer;
+}
+
 // Must be called single-threaded (early in main(), before any Timer is
 // created).  Sets up the epoch and enables collection.
 void ChromeTraceWriter::init() {
@@ -34,8 +62,36 @@ void ChromeTraceWriter::disable() {
   s_enabled.store(nullptr, std::memory_order_release);
   auto& s = get_state();
   std::lock_guard<std::mutex> guard(s.lock);
-  s.events.clear();
-  s.events.shrink_to_fit();
+  for (auto* buffer : s.buffers) {
+    std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+    buffer->events.clear();
+    buffer->events.shrink_to_fit();
+    buffer->names.clear();
+    buffer->name_ids.clear();
+  }
+}
+
+void ChromeTraceWriter::set_work_item_threshold(
+    std::chrono::nanoseconds threshold) {
+  s_work_item_threshold_ns.store(threshold.count(), std::memory_order_relaxed);
+}
+
+void ChromeTraceWriter::append(State& s,
+                               const std::string& name,
+                               Phase phase,
+                               time_point ts,
+                               uint64_t dur_or_value,
+                               uint64_t tid) {
+  auto ts_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(ts - s.epoch)
+          .count());
+  auto& buffer = get_thread_buffer(s);
+  std::lock_guard<std::mutex> guard(buffer.lock);
+  auto [it, inserted] = buffer.name_ids.emplace(name, buffer.names.size());
+  if (inserted) {
+    buffer.names.push_back(name);
+  }
+  buffer.events.push_back({it->second, phase, ts_ns, dur_or_value, tid});
 }
 
 void ChromeTraceWriter::record(const std::string& name,
@@ -46,16 +102,22 @@ void ChromeTraceWriter::record(const std::string& name,
   if (s == nullptr) {
     return;
   }
-  auto ts_us = static_cast<uint64_t>(
-      std::chrono::duration_cast<std::chrono::microseconds>(start - s->epoch)
-          .count());
-  auto dur_us = static_cast<uint64_t>(
-      std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+  auto dur_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
           .count());
-  auto tid_hash = std::hash<std::thread::id>{}(tid);
+  append(*s, name, Phase::Complete, start, dur_ns,
+         std::hash<std::thread::id>{}(tid));
+}
 
-  std::lock_guard<std::mutex> guard(s->lock);
-  s->events.push_back({name, ts_us, dur_us, tid_hash});
+void ChromeTraceWriter::record_counter(const std::string& name,
+                                       uint64_t value,
+                                       time_point ts) {
+  auto* s = s_enabled.load(std::memory_order_acquire);
+  if (s == nullptr) {
+    return;
+  }
+  append(*s, name, Phase::Counter, ts, value,
+         std::hash<std::thread::id>{}(std::this_thread::get_id()));
 }
 
 namespace {
@@ -95,13 +157,45 @@ void write_json_string(std::ofstream& out, const std::string& s) {
   }
   out << '"';
 }
+
+// Timestamps are in microseconds, with nanosecond precision where there is
+// any.
+void write_us(std::ofstream& out, uint64_t ns) {
+  out << ns / 1000;
+  auto frac = ns % 1000;
+  if (frac != 0) {
+    std::array<char, 8> buf;
+    snprintf(buf.data(), buf.size(), ".%03u", static_cast<unsigned>(frac));
+    out << buf.data();
+  }
+}
 } // namespace
 
 void ChromeTraceWriter::write(const std::string& path) {
+  struct Entry {
+    const Event* event;
+    const std::string* name;
+  };
   auto& s = get_state();
-  if (s.events.empty()) {
+  std::lock_guard<std::mutex> guard(s.lock);
+  std::vector<std::unique_lock<std::mutex>> buffer_locks;
+  buffer_locks.reserve(s.buffers.size());
+  std::vector<Entry> entries;
+  for (auto* buffer : s.buffers) {
+    buffer_locks.emplace_back(buffer->lock);
+    for (const auto& e : buffer->events) {
+      entries.push_back({&e, &buffer->names[e.name]});
+    }
+  }
+  if (entries.empty()) {
     return;
   }
+  // Merge the per-thread buffers into one timeline. Stable, so that events
+  // with equal timestamps keep the order of their recording thread.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.event->ts_ns < b.event->ts_ns;
+                   });
 
   std::ofstream out(path);
   if (!out) {
@@ -111,15 +205,28 @@ void ChromeTraceWriter::write(const std::string& path) {
 
   out << '[';
   bool first = true;
-  for (const auto& e : s.events) {
+  for (const auto& entry : entries) {
+    const auto& e = *entry.event;
     if (!first) {
       out << ',';
     }
     first = false;
     out << "{\"name\":";
-    write_json_string(out, e.name);
+    write_json_string(out, *entry.name);
+    if (e.phase == Phase::Counter) {
+      out << ",\"ph\":\"C\""
+          << ",\"ts\":";
+      write_us(out, e.ts_ns);
+      out << ",\"pid\":1"
+          << ",\"args\":{\"value\":" << e.dur_ns << "}}";
+      continue;
+    }
     out << ",\"ph\":\"X\""
-        << ",\"ts\":" << e.ts_us << ",\"dur\":" << e.dur_us << ",\"pid\":1"
+        << ",\"ts\":";
+    write_us(out, e.ts_ns);
+    out << ",\"dur\":";
+    write_us(out, e.dur_ns);
+    out << ",\"pid\":1"
         << ",\"tid\":" << e.tid << '}';
   }
   out << ']';
@@ -24,6 +24,10 @@
 //   ChromeTraceWriter::disable();     // stops recording, frees events
 //   // ... timers run, calling record() from their destructors ...
 //   ChromeTraceWriter::write(path);   // at shutdown (if still enabled)
+//
+// Events are appended to a buffer owned by the recording thread, so that
+// threads of parallel walks do not contend on a shared lock. Event names are
+// interned per buffer.
 class ChromeTraceWriter {
  public:
   using clock = std::chrono::high_resolution_clock;
@@ -50,24 +54,52 @@ class ChromeTraceWriter {
                      time_point end,
                      std::thread::id tid);
 
+  // Record a sample of a counter, e.g. RSS. Samples of the same name form a
+  // counter track in the viewer. Thread-safe.
+  static void record_counter(const std::string& name,
+                             uint64_t value,
+                             time_point ts);
+
+  // Individual work items of WorkQueues (and so of walk::parallel::*) that
+  // take at least this long are recorded as their own events. Zero, the
+  // default, records none.
+  static void set_work_item_threshold(std::chrono::nanoseconds threshold);
+
+  // The work item threshold, or zero when tracing is disabled. Cheap enough to
+  // be checked once per work item.
+  static std::chrono::nanoseconds work_item_threshold() {
+    if (!enabled()) {
+      return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(
+        s_work_item_threshold_ns.load(std::memory_order_relaxed));
+  }
+
   // Write all recorded events to a JSON file in Chrome Trace format.
   static void write(const std::string& path);
 
  private:
+  enum class Phase : uint8_t { Complete, Counter };
+
   struct Event {
-    std::string name;
-    uint64_t ts_us; // start timestamp in microseconds since epoch
-    uint64_t dur_us; // duration in microseconds
+    uint32_t name; // index into the names of the recording ThreadBuffer
+    Phase phase;
+    uint64_t ts_ns; // start timestamp in nanoseconds since epoch
+    uint64_t dur_ns; // duration in nanoseconds; counter value for counters
     uint64_t tid; // thread id
   };
 
+  struct ThreadBuffer;
+
   // Heap-allocated state that is intentionally never deleted, so that it
   // survives past static destructors.  This avoids the static destruction
   // order fiasco when exit() is called (e.g. --reflect-config) and other
   // statics (ConcurrentContainer mutexes) are destroyed before our state.
   struct State {
+    // Guards the list of buffers, not their contents.
     std::mutex lock;
-    std::vector<Event> events;
+    // Never shrinks, threads keep a pointer to their buffer.
+    std::vector<ThreadBuffer*> buffers;
     time_point epoch;
   };
 
@@ -76,5 +108,17 @@ class ChromeTraceWriter {
   // NOLINTNEXTLINE(facebook-hte-NonPodStaticDeclaration)
   static std::atomic<State*> s_enabled;
 
+  // NOLINTNEXTLINE(facebook-hte-NonPodStaticDeclaration)
+  static std::atomic<int64_t> s_work_item_threshold_ns;
+
   static State& get_state();
+
+  static ThreadBuffer& get_thread_buffer(State& s);
+
+  static void append(State& s,
+                     const std::string& name,
+                     Phase phase,
+                     time_point ts,
+                     uint64_t dur_or_value,
+                     uint64_t tid);
 };
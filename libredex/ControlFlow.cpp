@@ -17,6 +17,7 @@
 #include "DeterministicContainers.h"
 #include "DexInstruction.h"
 #include "DexPosition.h"
+#include "Dominators.h"
 #include "IRList.h"
 #include "InstructionLowering.h"
 #include "RedexContext.h"
@@ -758,6 +759,8 @@ std::ostream& operator<<(std::ostream& os, const Edge& e) {
 
 bool ControlFlowGraph::s_DEBUG = false;
 
+ControlFlowGraph::ControlFlowGraph() = default;
+
 ControlFlowGraph::ControlFlowGraph(IRList* ir, reg_t registers_size)
     : m_registers_size(registers_size) {
   always_assert_log(!ir->empty(), "IRList contains no instructions");
@@ -1204,7 +1207,7 @@ void ControlFlowGraph::remove_empty_blocks() {
       }
 
       if (b == entry_block()) {
-        m_entry_block = succ;
+        set_entry_block(succ);
       }
 
       // Move positions if succ doesn't have any
@@ -2251,6 +2254,7 @@ Block* ControlFlowGraph::create_block() {
   size_t id = next_block_id();
   Block* b = new Block(this, id);
   m_blocks.emplace(id, b);
+  bump_structure_version();
   return b;
 }
 
@@ -2417,9 +2421,9 @@ void ControlFlowGraph::calculate_exit_block() {
   std::vector<Block*> exit_blocks = collectExitBlocks(entry_block());
 
   if (exit_blocks.size() == 1) {
-    m_exit_block = exit_blocks[0];
+    set_exit_block(exit_blocks[0]);
   } else {
-    m_exit_block = create_block();
+    set_exit_block(create_block());
     for (Block* b : exit_blocks) {
       add_edge(b, m_exit_block, EDGE_GHOST);
     }
@@ -2431,7 +2435,7 @@ void ControlFlowGraph::reset_exit_block() {
     return;
   }
   if (get_pred_edge_of_type(m_exit_block, EDGE_GHOST) == nullptr) {
-    m_exit_block = nullptr;
+    set_exit_block(nullptr);
     return;
   }
   // If we get here, we have a "ghost" exit block, that was created to represent
@@ -2509,6 +2513,33 @@ void ControlFlowGraph::clear() {
 
   m_entry_block = nullptr;
   m_exit_block = nullptr;
+  bump_structure_version();
+}
+
+const dominators::SimpleFastDominators<GraphInterface>&
+ControlFlowGraph::get_dominators() const {
+  if (m_dominators == nullptr ||
+      m_dominators_version != m_structure_version) {
+    m_dominators =
+        std::make_unique<dominators::SimpleFastDominators<GraphInterface>>(
+            *this);
+    m_dominators_version = m_structure_version;
+  }
+  return *m_dominators;
+}
+
+const dominators::SimpleFastPostDominators<GraphInterface>&
+ControlFlowGraph::get_post_dominators() const {
+  always_assert_log(m_exit_block != nullptr,
+                    "calculate_exit_block() must be called first");
+  if (m_post_dominators == nullptr ||
+      m_post_dominators_version != m_structure_version) {
+    m_post_dominators =
+        std::make_unique<dominators::SimpleFastPostDominators<GraphInterface>>(
+            *this);
+    m_post_dominators_version = m_structure_version;
+  }
+  return *m_post_dominators;
 }
 
 namespace {
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -91,6 +92,16 @@ struct BlockAccessor;
 } // namespace impl
 } // namespace source_blocks
 
+namespace dominators {
+template <class GraphInterface>
+class SimpleFastDominators;
+} // namespace dominators
+
+namespace sparta {
+template <typename GraphInterface>
+class BackwardsFixpointIterationAdaptor;
+} // namespace sparta
+
 namespace cfg {
 
 enum EdgeType : uint8_t {
@@ -109,6 +120,7 @@ enum EdgeType : uint8_t {
 class Block;
 class ControlFlowGraph;
 class CFGInliner;
+class GraphInterface;
 
 namespace details {
 
@@ -493,7 +505,7 @@ class ControlFlowGraph {
  public:
   static bool s_DEBUG;
 
-  ControlFlowGraph() = default;
+  ControlFlowGraph();
   ControlFlowGraph(const ControlFlowGraph&) = delete;
 
   ControlFlowGraph(IRList* ir, reg_t registers_size);
@@ -556,10 +568,33 @@ class ControlFlowGraph {
   // `calculate_exit_block()` synthesize a ghost successor. Don't assume
   // "exit block == ghost" universally.
   Block* exit_block() const { return m_exit_block; }
-  void set_entry_block(Block* b) { m_entry_block = b; }
-  void set_exit_block(Block* b) { m_exit_block = b; }
+  void set_entry_block(Block* b) {
+    m_entry_block = b;
+    bump_structure_version();
+  }
+  void set_exit_block(Block* b) {
+    m_exit_block = b;
+    bump_structure_version();
+  }
   void reset_exit_block();
 
+  // The dominator tree of this CFG. It is computed on first use and shared by
+  // all the queries that follow, until the blocks, edges, entry or exit of the
+  // CFG change. A returned reference remains valid until the first query made
+  // after such a change. Queries are not thread-safe.
+  const dominators::SimpleFastDominators<GraphInterface>& get_dominators()
+      const;
+
+  // The post-dominator tree of this CFG, cached like `get_dominators`. The
+  // exit block must have been computed, see `calculate_exit_block`.
+  const dominators::SimpleFastDominators<
+      sparta::BackwardsFixpointIterationAdaptor<GraphInterface>>&
+  get_post_dominators() const;
+
+  // Incremented by every change to the blocks, edges, entry or exit of this
+  // CFG. Instruction changes within blocks do not count.
+  size_t structure_version() const { return m_structure_version; }
+
   /*
    * If there is a single method exit point, this returns a vector holding the
    * exit block. If there are multiple method exit points, this returns a vector
@@ -592,6 +627,7 @@ class ControlFlowGraph {
     m_edges.insert(e);
     e->src()->m_succs.push_back(e);
     e->target()->m_preds.push_back(e);
+    bump_structure_version();
   }
 
   // copies all edges from one block to another
@@ -1242,6 +1278,7 @@ class ControlFlowGraph {
                                        }),
                         reverse_edges.end());
 
+    bump_structure_version();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1280,6 +1317,7 @@ class ControlFlowGraph {
           forward_edges.end());
     }
 
+    bump_structure_version();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1318,6 +1356,7 @@ class ControlFlowGraph {
           reverse_edges.end());
     }
 
+    bump_structure_version();
     if (cleanup) {
       cleanup_deleted_edges(to_remove);
     }
@@ -1353,6 +1392,10 @@ class ControlFlowGraph {
 
   std::vector<Block*> blocks_post_helper(bool reverse) const;
 
+  // Called on every structural change, which invalidates the cached dominator
+  // and post-dominator trees.
+  void bump_structure_version() { ++m_structure_version; }
+
   // The memory of all blocks and edges in this graph are owned here
   Blocks m_blocks;
   EdgeSet m_edges;
@@ -1363,6 +1406,15 @@ class ControlFlowGraph {
   bool m_owns_insns{false};
   bool m_owns_removed_insns{true};
   std::vector<IRInstruction*> m_removed_insns;
+
+  size_t m_structure_version{0};
+  mutable size_t m_dominators_version{0};
+  mutable std::unique_ptr<dominators::SimpleFastDominators<GraphInterface>>
+      m_dominators;
+  mutable size_t m_post_dominators_version{0};
+  mutable std::unique_ptr<dominators::SimpleFastDominators<
+      sparta::BackwardsFixpointIterationAdaptor<GraphInterface>>>
+      m_post_dominators;
 };
 
 // A static-method-only API for use with the monotonic fixpoint iterator.
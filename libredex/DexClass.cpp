@@ -346,10 +346,14 @@ DexFieldRef* DexField::make_field(std::string_view full_descriptor) {
 void DexField::set_external() {
   always_assert_log(!m_concrete, "Unexpected concrete field %s\n",
                     self_show().c_str());
-  m_deobfuscated_name = self_show();
+  m_deobfuscated_name = DexString::make_string(self_show());
   m_external = true;
 }
 
+void DexField::set_deobfuscated_name(std::string_view name) {
+  m_deobfuscated_name = DexString::make_string(name);
+}
+
 void DexField::set_value(std::unique_ptr<DexEncodedValue> v) {
   always_assert_log(
       m_concrete,
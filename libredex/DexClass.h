@@ -337,7 +337,7 @@ class DexField : public DexFieldRef {
   DexAccessFlags m_access;
   std::unique_ptr<DexAnnotationSet> m_anno;
   std::unique_ptr<DexEncodedValue> m_value; /* Static Only */
-  std::string m_deobfuscated_name;
+  const DexString* m_deobfuscated_name{nullptr};
 
   // See UNIQUENESS above for the rationale for the private constructor pattern.
   DexField(DexType* container, const DexString* name, DexType* type);
@@ -409,15 +409,27 @@ class DexField : public DexFieldRef {
 
   void set_external();
 
-  void set_deobfuscated_name(std::string name) {
-    m_deobfuscated_name = std::move(name);
+  void set_deobfuscated_name(std::string_view name);
+  void set_deobfuscated_name(const DexString* name) {
+    m_deobfuscated_name = name;
   }
-  const std::string& get_deobfuscated_name() const {
-    return m_deobfuscated_name;
+
+  // Unlike for methods and classes, a field's deobfuscated name may be empty.
+  std::string_view get_deobfuscated_name() const {
+    return get_deobfuscated_name_or_empty();
   }
-  const std::string& get_deobfuscated_name_or_empty() const {
+  const DexString* get_deobfuscated_name_or_null() const {
     return m_deobfuscated_name;
   }
+  std::string_view get_deobfuscated_name_or_empty() const {
+    if (m_deobfuscated_name == nullptr) {
+      return std::string_view();
+    }
+    return m_deobfuscated_name->str();
+  }
+  std::string get_deobfuscated_name_or_empty_copy() const {
+    return ::str_copy(get_deobfuscated_name_or_empty());
+  }
 
   // Return just the name of the field.
   std::string get_simple_deobfuscated_name() const;
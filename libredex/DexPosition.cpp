@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <cstdio>
 #include <fstream>
 #include <type_traits>
 
@@ -137,8 +138,12 @@ void RealPositionMapper::register_position(DexPosition* pos) {
 int64_t RealPositionMapper::add_position(DexPosition* pos) {
   auto [it, _] = m_pos_line_map.emplace(pos, -1);
   if (it->second == -1) {
-    it->second = static_cast<int64_t>(m_positions.size());
-    m_positions.push_back(pos);
+    auto [value_it, emplaced] = m_value_line_map.emplace(
+        pos, static_cast<int64_t>(m_positions.size()));
+    if (emplaced) {
+      m_positions.push_back(pos);
+    }
+    it->second = value_it->second;
   }
   return it->second;
 }
@@ -224,6 +229,14 @@ void RealPositionMapper::process_pattern_switch_positions() {
   // 101: method Lredex/$Position;.count:()V, line 2 (no parent)
   // 102: method Lredex/$Position;.case:()V, line 12345, parent 23
   // 103: method Lredex/$Position;.case:()V, line 54321, parent 42
+  //
+  // The entries of a switch must be consecutive, so unlike other positions,
+  // they are not shared with equal positions emitted earlier.
+  auto append_auxiliary_position = [&](DexPosition* pos) {
+    m_owned_auxiliary_positions.emplace_back(pos);
+    m_pos_line_map.emplace(pos, static_cast<int64_t>(m_positions.size()));
+    m_positions.push_back(pos);
+  };
   UnorderedMap<uint32_t, uint32_t> switch_line_map;
   for (uint32_t switch_id = 0; switch_id < switches.size(); ++switch_id) {
     if (reachable_switches.count(switch_id) == 0u) {
@@ -239,12 +252,7 @@ void RealPositionMapper::process_pattern_switch_positions() {
       }
       for (auto* pos = c.position; (pos != nullptr) && (pos->file != nullptr);
            pos = pos->parent) {
-        auto [it, emplaced] = m_pos_line_map.emplace(pos, m_positions.size());
-        if (emplaced) {
-          m_positions.push_back(pos);
-        } else {
-          always_assert(it->second != -1);
-        }
+        add_position(pos);
       }
       reachable_cases.push_back(c);
     }
@@ -256,21 +264,16 @@ void RealPositionMapper::process_pattern_switch_positions() {
               });
     // We emit a first entry holding the count
     switch_line_map.emplace(switch_id, m_positions.size());
-    {
-      auto* count_pos = new DexPosition(count_string, unknown_source_string,
-                                        reachable_cases.size());
-      m_owned_auxiliary_positions.emplace_back(count_pos);
-      add_position(count_pos);
-    }
+    append_auxiliary_position(new DexPosition(
+        count_string, unknown_source_string, reachable_cases.size()));
     // Then we emit consecutive list of cases
     for (auto& c : reachable_cases) {
       auto* case_pos =
           new DexPosition(case_string, unknown_source_string, c.pattern_id);
-      m_owned_auxiliary_positions.emplace_back(case_pos);
       always_assert(c.position);
       always_assert(c.position->file);
       case_pos->parent = c.position;
-      add_position(case_pos);
+      append_auxiliary_position(case_pos);
     }
   }
 
@@ -286,6 +289,8 @@ void RealPositionMapper::process_pattern_switch_positions() {
   // (some line): method Lredex/$Position;.pattern:()V, line 12345
   //
   // TODO: Should we undo this when we are done writing the map?
+  // This changes the value of positions, so no more positions may be added.
+  m_value_line_map.clear();
   for (auto* pos : m_positions) {
     if (manager->is_switch_position(pos)) {
       pos->line = switch_line_map.at(pos->line);
@@ -301,12 +306,7 @@ void RealPositionMapper::write_map_v2() {
   while (!m_possibly_incomplete_positions.empty()) {
     auto* pos = m_possibly_incomplete_positions.front();
     m_possibly_incomplete_positions.pop();
-    auto& line = m_pos_line_map[pos];
-    if (line == -1) {
-      auto idx = m_positions.size();
-      m_positions.emplace_back(pos);
-      line = static_cast<int64_t>(idx);
-    }
+    add_position(pos);
   }
 
   process_pattern_switch_positions();
@@ -323,6 +323,18 @@ void RealPositionMapper::write_map_v2() {
    * Each member of the string pool is encoded as follows:
    * string_length (4 bytes)
    * char[string_length]
+   *
+   * Next to the map, we write an index file (the map file name followed by
+   * ".idx") that lets tools use the map in place after mapping it into
+   * memory, without walking the variable-length string pool:
+   * 0xfaceb000 (magic number)
+   * version (4 bytes)
+   * map_size (8 bytes), the size of the indexed map file
+   * string_pool_size (4 bytes)
+   * positions_size (4 bytes)
+   * positions_offset (4 bytes), the offset of positions[] in the map file
+   * string_offsets[string_pool_size] (4 bytes each), the offsets of the
+   *   string_length fields in the map file
    */
 
   // We initially build a somewhat dense mapping of strings to ids; the exact
@@ -433,6 +445,9 @@ void RealPositionMapper::write_map_v2() {
   uint32_t spool_count = static_cast<uint32_t>(string_pool.size());
   ofs.write(reinterpret_cast<const char*>(&spool_count), sizeof(spool_count));
   always_assert(string_pool.size() < std::numeric_limits<uint32_t>::max());
+  uint64_t map_size = sizeof(magic) + sizeof(version) + sizeof(spool_count);
+  std::vector<uint32_t> string_offsets;
+  string_offsets.reserve(spool_count);
 
   // Finally, rewrite the string-ids following the deterministic ordering of the
   // positions.
@@ -447,6 +462,8 @@ void RealPositionMapper::write_map_v2() {
       uint32_t ssize = static_cast<uint32_t>(s->size());
       ofs.write(reinterpret_cast<const char*>(&ssize), sizeof(ssize));
       ofs.write(s->data(), static_cast<std::streamsize>(ssize * sizeof(char)));
+      string_offsets.push_back(static_cast<uint32_t>(map_size));
+      map_size += sizeof(ssize) + ssize;
       mapped = next_mapped++;
     }
     string_id = mapped - first_mapped;
@@ -461,11 +478,35 @@ void RealPositionMapper::write_map_v2() {
   ofs.write(reinterpret_cast<const char*>(&pos_count), sizeof(pos_count));
   ofs.write(reinterpret_cast<const char*>(pos_data.data()),
             static_cast<std::streamsize>(sizeof(uint32_t) * pos_data.size()));
-
+  map_size += sizeof(pos_count);
+  uint32_t pos_offset = static_cast<uint32_t>(map_size);
+  map_size += sizeof(uint32_t) * pos_data.size();
   TRACE(OPUT, 2,
         "positions: %zu, string pool size: %zu, semi-dense string ids: %u",
         m_positions.size(), string_pool.size(),
         next_semi_dense_string_id.load());
+
+  // The index is optional, tools fall back to scanning the map without it.
+  auto idx_filename = m_filename_v2 + ".idx";
+  if (map_size >= std::numeric_limits<uint32_t>::max()) {
+    TRACE(OPUT, 0, "Line map too large to index, not writing %s",
+          idx_filename.c_str());
+    std::remove(idx_filename.c_str());
+    return;
+  }
+
+  std::ofstream idx(idx_filename,
+                    std::ofstream::out | std::ofstream::trunc);
+  uint32_t idx_version = 1;
+  idx.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+  idx.write(reinterpret_cast<const char*>(&idx_version), sizeof(idx_version));
+  idx.write(reinterpret_cast<const char*>(&map_size), sizeof(map_size));
+  idx.write(reinterpret_cast<const char*>(&spool_count), sizeof(spool_count));
+  idx.write(reinterpret_cast<const char*>(&pos_count), sizeof(pos_count));
+  idx.write(reinterpret_cast<const char*>(&pos_offset), sizeof(pos_offset));
+  idx.write(reinterpret_cast<const char*>(string_offsets.data()),
+            static_cast<std::streamsize>(sizeof(uint32_t) *
+                                         string_offsets.size()));
 }
 
 PositionMapper* PositionMapper::make(const std::string& map_filename_v2) {
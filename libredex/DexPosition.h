@@ -56,6 +56,17 @@ inline size_t hash_value(const DexPosition& pos) {
 }
 using DexPositionHasher = boost::hash<DexPosition>;
 
+// Hashes and compares positions by value, including their parent chains, so
+// that separately allocated copies of a position are considered the same.
+struct DexPositionValueHasher {
+  size_t operator()(const DexPosition* pos) const { return hash_value(*pos); }
+};
+struct DexPositionValueEqual {
+  bool operator()(const DexPosition* a, const DexPosition* b) const {
+    return *a == *b;
+  }
+};
+
 using PositionPattern = std::vector<DexPosition*>;
 using PositionPatternHasher = boost::hash<PositionPattern>;
 
@@ -169,6 +180,13 @@ class RealPositionMapper : public PositionMapper {
   std::string m_filename_v2;
   std::vector<DexPosition*> m_positions;
   UnorderedMap<DexPosition*, int64_t> m_pos_line_map;
+  // Inlining and other code duplication leave many copies of the same
+  // position, possibly with copied parents. They all share one line.
+  UnorderedMap<const DexPosition*,
+               int64_t,
+               DexPositionValueHasher,
+               DexPositionValueEqual>
+      m_value_line_map;
   std::queue<DexPosition*> m_possibly_incomplete_positions;
   std::vector<std::unique_ptr<DexPosition>> m_owned_auxiliary_positions;
 
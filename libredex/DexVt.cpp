@@ -657,7 +657,7 @@ void Exporter::emit(ConfigFiles& conf,
     } else {
       r["class"] = show(fr.field->get_class());
     }
-    r["field"] = bare_method(fr.field->get_deobfuscated_name_or_empty());
+    r["field"] = bare_method(fr.field->get_deobfuscated_name_or_empty_copy());
     r["access"] = static_cast<Json::UInt>(fr.field->get_access());
     if (!fr.dex.empty()) {
       r["dex"] = fr.dex;
@@ -7,7 +7,8 @@
 
 #pragma once
 
-#include <optional>
+#include <limits>
+#include <vector>
 
 #include <sparta/MonotonicFixpointIterator.h>
 
@@ -26,73 +27,100 @@ class SimpleFastDominators {
    * algorithm is described in the following paper:
    *
    *    K. D. Cooper et.al. A Simple, Fast Dominance Algorithm.
+   *
+   * Nodes are numbered densely in postorder, and the fixpoint iteration only
+   * manipulates these numbers: the predecessors of each node are resolved to
+   * their numbers once, and the immediate dominators are kept in a vector
+   * indexed by number.
    */
   explicit SimpleFastDominators(const typename GraphInterface::Graph& graph) {
     // Sort nodes in postorder and create a map of each node to its postorder
     // number.
     m_postordering = graph::postorder_sort<GraphInterface>(graph);
-    for (size_t i = 0; i < m_postordering.size(); ++i) {
-      m_postorder_map[m_postordering[i]] = i;
+    const size_t size = m_postordering.size();
+    if (size == 0) {
+      return;
+    }
+    m_postorder_map.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      m_postorder_map.emplace(m_postordering[i], i);
+    }
+
+    // Only the predecessors that are reachable from the entry take part in the
+    // computation.
+    std::vector<std::vector<size_t>> preds(size);
+    for (size_t i = 0; i < size; ++i) {
+      for (const auto& pred :
+           GraphInterface::predecessors(graph, m_postordering[i])) {
+        auto it = m_postorder_map.find(GraphInterface::source(graph, pred));
+        if (it != m_postorder_map.end()) {
+          preds[i].push_back(it->second);
+        }
+      }
     }
-    // Entry node's immediate dominator is itself.
-    const auto& entry = GraphInterface::entry(graph);
+
+    // Entry node's immediate dominator is itself. It is the last node in
+    // postorder.
+    const size_t entry = size - 1;
+    always_assert(m_postordering[entry] == GraphInterface::entry(graph));
+    m_idoms.assign(size, UNDEFINED);
     m_idoms[entry] = entry;
 
     bool changed = true;
     while (changed) {
       changed = false;
-      // Traverse nodes in reverse postorder.
-      for (auto rit = m_postordering.rbegin(); rit != m_postordering.rend();
-           ++rit) {
-        NodeId node = *rit;
-        if (node == entry) {
-          continue;
-        }
-        const auto& preds = GraphInterface::predecessors(graph, node);
-        std::optional<NodeId> new_idom;
-        for (auto& pred : preds) {
-          const auto& src = GraphInterface::source(graph, pred);
-          if (!m_idoms.count(src)) {
+      // Traverse nodes in reverse postorder, skipping the entry.
+      for (size_t node = entry; node-- > 0;) {
+        size_t new_idom = UNDEFINED;
+        for (auto pred : preds[node]) {
+          if (m_idoms[pred] == UNDEFINED) {
             continue;
           }
-          if (!new_idom) {
-            new_idom = GraphInterface::source(graph, pred);
-          } else {
-            new_idom = intersect(*new_idom, src);
-          }
+          new_idom =
+              new_idom == UNDEFINED ? pred : intersect_numbers(new_idom, pred);
         }
-        always_assert(new_idom);
-        if (!m_idoms.count(node) || m_idoms.at(node) != *new_idom) {
-          m_idoms[node] = *new_idom;
+        always_assert(new_idom != UNDEFINED);
+        if (m_idoms[node] != new_idom) {
+          m_idoms[node] = new_idom;
           changed = true;
         }
       }
     }
   }
 
-  NodeId get_idom(NodeId node) const { return m_idoms.at(node); }
+  NodeId get_idom(NodeId node) const {
+    return m_postordering[m_idoms[m_postorder_map.at(node)]];
+  }
 
   // True when `node` has a recorded immediate dominator. Nodes absent from the
   // computation (for the post-dominator instantiation, blocks that cannot reach
   // the exit) return false; query this before `get_idom` rather than catching
   // the throwing `at()` lookup.
-  bool has_idom(NodeId node) const { return m_idoms.count(node) != 0u; }
+  bool has_idom(NodeId node) const { return m_postorder_map.count(node) != 0u; }
 
   // Find the common dominator block that is closest to both blocks.
-  NodeId intersect(NodeId finger1, NodeId finger2) {
+  NodeId intersect(NodeId finger1, NodeId finger2) const {
+    return m_postordering[intersect_numbers(m_postorder_map.at(finger1),
+                                            m_postorder_map.at(finger2))];
+  }
+
+ private:
+  static constexpr size_t UNDEFINED = std::numeric_limits<size_t>::max();
+
+  size_t intersect_numbers(size_t finger1, size_t finger2) const {
     while (finger1 != finger2) {
-      while (m_postorder_map.at(finger1) < m_postorder_map.at(finger2)) {
-        finger1 = m_idoms.at(finger1);
+      while (finger1 < finger2) {
+        finger1 = m_idoms[finger1];
       }
-      while (m_postorder_map.at(finger2) < m_postorder_map.at(finger1)) {
-        finger2 = m_idoms.at(finger2);
+      while (finger2 < finger1) {
+        finger2 = m_idoms[finger2];
       }
     }
     return finger1;
   }
 
- private:
-  UnorderedMap<NodeId, NodeId> m_idoms;
+  // The immediate dominator of each node, by postorder number.
+  std::vector<size_t> m_idoms;
   std::vector<NodeId> m_postordering;
   UnorderedMap<NodeId, size_t> m_postorder_map;
 };
@@ -119,6 +119,10 @@ void IRTypeCheckerConfig::bind_config() {
   bind("run_on_input", run_on_input, run_on_input);
   bind("run_on_input_ignore_access", run_on_input_ignore_access,
        run_on_input_ignore_access);
+  bind("incremental", incremental, incremental,
+       "Only re-check methods whose code, signature, referenced definitions "
+       "or relevant class hierarchy changed since they last passed the "
+       "check.");
   bind("external_check", external_check, external_check,
        "ON/OFF switch for dex code validation in external class and internal "
        "class hierarchy - no external class should be inheriting internal "
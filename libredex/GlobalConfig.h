@@ -43,6 +43,7 @@ struct IRTypeCheckerConfig : public Configurable {
   bool run_on_input_ignore_access{false};
   bool external_check{false};
   bool definition_check{false};
+  bool incremental{false};
   UnorderedSet<std::string> run_after_passes;
   UnorderedSet<std::string> external_check_allowlist;
   UnorderedSet<std::string> definition_check_allowlist;
@@ -7,10 +7,12 @@
 
 #include "IRList.h"
 
+#include <cstring>
 #include <iterator>
 #include <sstream>
 #include <vector>
 
+#include "ConcurrentContainers.h"
 #include "Debug.h"
 #include "DexClass.h"
 #include "DexDebugInstruction.h"
@@ -1072,6 +1074,16 @@ SourceBlock& SourceBlock::operator=(const SourceBlock& other) {
   return *this;
 }
 
+std::unique_ptr<SourceBlock::Storage, SourceBlock::FreeDeleter>
+SourceBlock::allocate_storage(InteractionBitSet bits) {
+  size_t bytes = offsetof(Storage, data) + sizeof(Val) * bits.count();
+  auto* res = (Storage*)malloc(bytes);
+  always_assert(res);
+  res->bits = bits;
+  res->interned = false;
+  return std::unique_ptr<Storage, FreeDeleter>(res);
+}
+
 std::unique_ptr<SourceBlock::Storage, SourceBlock::FreeDeleter>
 SourceBlock::make_storage(size_t vals_size, const Val& val) {
   if (vals_size == 0) {
@@ -1079,12 +1091,9 @@ SourceBlock::make_storage(size_t vals_size, const Val& val) {
   }
 
   always_assert(vals_size <= InteractionBitSet::MAX_SIZE);
-  size_t bytes = sizeof(Storage) + sizeof(Val) * (vals_size - 1);
-  auto* res = (Storage*)malloc(bytes);
-  always_assert(res);
-  res->bits = InteractionBitSet::all(vals_size);
+  auto res = allocate_storage(InteractionBitSet::all(vals_size));
   std::fill_n(res->data, vals_size, val);
-  return std::unique_ptr<Storage, FreeDeleter>(res);
+  return res;
 }
 
 std::unique_ptr<SourceBlock::Storage, SourceBlock::FreeDeleter>
@@ -1092,6 +1101,10 @@ SourceBlock::make_storage(const Storage* other) {
   if (other == nullptr) {
     return nullptr;
   }
+  if (other->interned) {
+    // Interned storage never holds default values, so it can be shared as is.
+    return std::unique_ptr<Storage, FreeDeleter>(const_cast<Storage*>(other));
+  }
   InteractionBitSet bits;
   auto other_bits = other->bits;
   for (size_t i = 0; other_bits; other_bits.remove_first(), i++) {
@@ -1102,17 +1115,14 @@ SourceBlock::make_storage(const Storage* other) {
   if (!bits) {
     return nullptr;
   }
-  size_t bytes = sizeof(Storage) + sizeof(Val) * (bits.count() - 1);
-  auto* res = (Storage*)malloc(bytes);
-  always_assert(res);
-  res->bits = bits;
+  auto res = allocate_storage(bits);
   other_bits = other->bits;
   for (size_t i = 0, j = 0; other_bits; other_bits.remove_first(), i++) {
     if (bits.contains(other_bits.first())) {
       res->data[j++] = other->data[i];
     }
   }
-  return std::unique_ptr<Storage, FreeDeleter>(res);
+  return res;
 }
 
 std::unique_ptr<SourceBlock::Storage, SourceBlock::FreeDeleter>
@@ -1127,14 +1137,56 @@ SourceBlock::make_storage(const std::vector<Val>& vals) {
   if (!bits) {
     return nullptr;
   }
-  size_t bytes = sizeof(Storage) + sizeof(Val) * (bits.count() - 1);
-  auto* res = (Storage*)malloc(bytes);
-  always_assert(res);
-  res->bits = bits;
+  auto res = allocate_storage(bits);
   for (size_t i = 0; bits; bits.remove_first(), i++) {
     res->data[i] = vals[bits.first_index()];
   }
-  return std::unique_ptr<Storage, FreeDeleter>(res);
+  // Blocks built from profiles often carry identical values (e.g. always hit,
+  // or only hit in one interaction), so share them.
+  return intern_storage(std::move(res));
+}
+
+struct SourceBlock::StorageHasher {
+  size_t operator()(const Storage* storage) const {
+    size_t hash = std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<const char*>(storage->data),
+                         sizeof(Val) * storage->bits.count()));
+    boost::hash_combine(hash, storage->bits.hash());
+    return hash;
+  }
+};
+
+struct SourceBlock::StorageEqual {
+  bool operator()(const Storage* a, const Storage* b) const {
+    return a->bits == b->bits &&
+           std::memcmp(a->data, b->data, sizeof(Val) * a->bits.count()) == 0;
+  }
+};
+
+std::unique_ptr<SourceBlock::Storage, SourceBlock::FreeDeleter>
+SourceBlock::intern_storage(std::unique_ptr<Storage, FreeDeleter> storage) {
+  if (!storage || storage->interned) {
+    return storage;
+  }
+  // Interned storage lives for the rest of the process, like DexStrings.
+  static auto* interned_storages =
+      new InsertOnlyConcurrentSet<const Storage*, StorageHasher, StorageEqual>();
+  storage->interned = true;
+  auto [ptr, inserted] = interned_storages->insert(storage.get());
+  if (inserted) {
+    return storage;
+  }
+  std::free(storage.release());
+  return std::unique_ptr<Storage, FreeDeleter>(const_cast<Storage*>(*ptr));
+}
+
+void SourceBlock::unshare_storage() {
+  if (!m_storage || !m_storage->interned) {
+    return;
+  }
+  auto res = allocate_storage(m_storage->bits);
+  std::copy_n(m_storage->data, m_storage->bits.count(), res->data);
+  m_storage = std::move(res);
 }
 
 bool SourceBlock::has_all_default_values(const Storage* storage) {
@@ -1232,7 +1284,7 @@ void SourceBlock::fill(const Val& val) {
     m_storage.reset();
     return;
   }
-  if (is_storage_expanded()) {
+  if (is_storage_expanded() && (vals_size == 0 || !m_storage->interned)) {
     if (vals_size > 0) {
       std::fill_n(m_storage->data, vals_size, val);
     }
@@ -1294,6 +1346,7 @@ bool SourceBlock::normalize(size_t* elided_vals, size_t* unelided_vals) {
   if (!m_storage) {
     return true;
   }
+  m_storage = intern_storage(std::move(m_storage));
   size_t count = m_storage->bits.count();
   *elided_vals += vals_size - count;
   *unelided_vals += count;
@@ -10,6 +10,7 @@
 #include <bit>
 #include <boost/intrusive/list.hpp>
 #include <boost/range/sub_range.hpp>
+#include <cstring>
 #include <functional>
 #include <iosfwd>
 #include <limits>
@@ -228,6 +229,8 @@ struct SourceBlock {
         return;
       }
       expand_storage();
+    } else {
+      unshare_storage();
     }
     size_t idx = m_storage->bits.count_before_index(i);
     m_storage->data[idx] = val;
@@ -248,7 +251,7 @@ struct SourceBlock {
       return;
     }
     size_t idx = m_storage->bits.count_before_index(i);
-    fn(m_storage->data[idx]);
+    invoke_on_data(i, idx, fn);
   }
 
   template <typename Fn>
@@ -288,8 +291,7 @@ struct SourceBlock {
     for (size_t i = 0; i < vals_size; i++) {
       if (m_storage->bits.contains_index(i)) {
         size_t idx = m_storage->bits.count_before_index(i);
-        Val& val = m_storage->data[idx];
-        invoke_fn(fn, i, val);
+        invoke_on_data(i, idx, fn);
       } else {
         Val val = Val::default_value();
         invoke_fn(fn, i, val);
@@ -348,8 +350,7 @@ struct SourceBlock {
     for (size_t i = 0; i < vals_size; i++) {
       if (m_storage->bits.contains_index(i)) {
         size_t idx = m_storage->bits.count_before_index(i);
-        Val& val = m_storage->data[idx];
-        if (invoke_fn(fn, i, val)) {
+        if (invoke_on_data(i, idx, fn)) {
           return true;
         }
       } else {
@@ -482,6 +483,8 @@ struct SourceBlock {
 
     size_t count() const { return std::popcount(m_bits); }
 
+    size_t hash() const { return std::hash<uint64_t>()(m_bits); }
+
     size_t count_before_index(size_t i) const {
       return count_before(from_index(i));
     }
@@ -501,16 +504,51 @@ struct SourceBlock {
 
   struct Storage {
     InteractionBitSet bits; // for each set bit, we have a data entry
+    // Interned storage is owned by a global table, shared by all blocks with
+    // the same values, and never modified or freed. Blocks copy it out before
+    // writing to it.
+    bool interned;
     Val data[1]; // variable sized, matching number of bits set
   };
 
   struct FreeDeleter {
-    void operator()(void* p) const { std::free(p); }
+    void operator()(Storage* p) const {
+      if (!p->interned) {
+        std::free(p);
+      }
+    }
   };
 
+  struct StorageHasher;
+  struct StorageEqual;
+
   // nullptr m_storage represents vals_size many Val::default_value() values.
   std::unique_ptr<Storage, FreeDeleter> m_storage;
 
+  // Applies `fn` to the data entry at `idx`, which stores index `i`. Interned
+  // storage is only copied out when `fn` actually changes the value.
+  template <typename Fn>
+  auto invoke_on_data(size_t i, size_t idx, const Fn& fn) {
+    if (!m_storage->interned) {
+      return invoke_fn(fn, i, m_storage->data[idx]);
+    }
+    Val val = m_storage->data[idx];
+    auto write_back = [&]() {
+      if (std::memcmp(&val, &m_storage->data[idx], sizeof(Val)) != 0) {
+        unshare_storage();
+        m_storage->data[idx] = val;
+      }
+    };
+    if constexpr (std::is_void_v<decltype(invoke_fn(fn, i, val))>) {
+      invoke_fn(fn, i, val);
+      write_back();
+    } else {
+      auto res = invoke_fn(fn, i, val);
+      write_back();
+      return res;
+    }
+  }
+
   template <typename Fn, typename ValType>
   static auto invoke_fn(const Fn& fn, size_t i, ValType& val) {
     if constexpr (std::is_invocable_v<Fn, size_t, ValType&>) {
@@ -529,6 +567,18 @@ struct SourceBlock {
   static std::unique_ptr<Storage, FreeDeleter> make_storage(
       const std::vector<Val>& vals);
 
+  static std::unique_ptr<Storage, FreeDeleter> allocate_storage(
+      InteractionBitSet bits);
+
+  // Returns the interned storage equal to `storage`, freeing `storage` if an
+  // equal one was already interned.
+  static std::unique_ptr<Storage, FreeDeleter> intern_storage(
+      std::unique_ptr<Storage, FreeDeleter> storage);
+
+  // Replaces interned storage by a private copy with the same layout, so that
+  // data indices remain valid.
+  void unshare_storage();
+
   static bool has_all_default_values(const Storage* storage);
 
   static bool has_default_value(const Storage* storage);
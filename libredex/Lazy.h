@@ -40,6 +40,8 @@ class Lazy {
     redex_assert(m_value);
     return m_value.get();
   }
+  // Takes ownership of the value, if it has been created.
+  std::unique_ptr<T> release() { return std::move(m_value); }
 
  private:
   std::function<std::unique_ptr<T>()> m_creator;
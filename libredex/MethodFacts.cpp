@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "MethodFacts.h"
+
+#include "ControlFlow.h"
+#include "EditableCfgAdapter.h"
+#include "IRCode.h"
+#include "IRInstruction.h"
+#include "Walkers.h"
+
+MethodFacts::MethodFacts(const DexMethod* method) {
+  const auto* code = method->get_code();
+  if (code == nullptr) {
+    return;
+  }
+  instructions = code->count_opcodes();
+  code_units = code->estimate_code_units();
+  cfg_adapter::iterate(code, [&](const MethodItemEntry& mie) {
+    auto* insn = mie.insn;
+    auto op = insn->opcode();
+    if (op == OPCODE_MONITOR_ENTER) {
+      monitor_enters++;
+    } else if (op == OPCODE_THROW) {
+      has_throws = true;
+    }
+    if (insn->has_method()) {
+      invoked_methods.push_back(insn->get_method());
+    } else if (insn->has_field()) {
+      field_refs.push_back(insn->get_field());
+    }
+    return cfg_adapter::LOOP_CONTINUE;
+  });
+  if (code->cfg_built()) {
+    auto blocks = code->cfg().blocks();
+    has_catches =
+        std::any_of(blocks.begin(), blocks.end(),
+                    [](cfg::Block* block) { return block->is_catch(); });
+  } else {
+    has_catches = std::any_of(code->begin(), code->end(), [](const auto& mie) {
+      return mie.type == MFLOW_CATCH;
+    });
+  }
+}
+
+bool MethodFacts::operator==(const MethodFacts& other) const {
+  return instructions == other.instructions &&
+         code_units == other.code_units &&
+         monitor_enters == other.monitor_enters &&
+         has_catches == other.has_catches && has_throws == other.has_throws &&
+         invoked_methods == other.invoked_methods &&
+         field_refs == other.field_refs;
+}
+
+MethodFactsCache::MethodFactsCache(const Scope& scope) {
+  walk::parallel::methods(scope, [&](DexMethod* method) {
+    m_cache.emplace(method, MethodFacts(method));
+  });
+}
+
+const MethodFacts& MethodFactsCache::get(const DexMethod* method) const {
+  return *m_cache
+              .get_or_create_and_assert_equal(
+                  method, [](const auto* m) { return MethodFacts(m); })
+              .first;
+}
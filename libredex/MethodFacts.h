@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "ConcurrentContainers.h"
+#include "DexClass.h"
+
+/*
+ * Cheap per-method facts that many passes otherwise gather with their own
+ * walk over all code. Methods without code have all-zero facts.
+ */
+struct MethodFacts {
+  MethodFacts() = default;
+  explicit MethodFacts(const DexMethod* method);
+
+  bool operator==(const MethodFacts& other) const;
+
+  // Number of opcodes, as in IRCode::count_opcodes().
+  uint32_t instructions{0};
+  // Estimated size of the code, as in IRCode::estimate_code_units().
+  uint32_t code_units{0};
+  uint32_t monitor_enters{0};
+  bool has_catches{false};
+  bool has_throws{false};
+  // Referenced methods and fields, in instruction order and with duplicates.
+  std::vector<DexMethodRef*> invoked_methods;
+  std::vector<DexFieldRef*> field_refs;
+};
+
+/*
+ * Facts for all methods of a scope, built in parallel. Methods not in the
+ * scope are computed on demand.
+ *
+ * The cache is not notified of IR changes, so it must be dropped once code
+ * is mutated. The PassManager drops its cache after every pass that does not
+ * preserve all analyses.
+ */
+class MethodFactsCache {
+ public:
+  explicit MethodFactsCache(const Scope& scope);
+
+  // This operation is thread-safe.
+  const MethodFacts& get(const DexMethod* method) const;
+
+ private:
+  mutable InsertOnlyConcurrentMap<const DexMethod*, MethodFacts> m_cache;
+};
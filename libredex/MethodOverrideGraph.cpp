@@ -8,6 +8,9 @@
 #include "MethodOverrideGraph.h"
 
 #include <iterator>
+#include <optional>
+#include <vector>
+
 #include <sparta/PatriciaTreeMap.h>
 #include <sparta/PatriciaTreeSet.h>
 
@@ -405,6 +408,69 @@ class GraphBuilder {
   GraphConfig m_config;
 };
 
+// The nodes visited by a traversal of the graph. To avoid allocating a set per
+// query, each thread keeps one bit per node id, and clears the bits it set when
+// the traversal ends. A traversal started from the callback of another one on
+// the same thread uses a set instead.
+class VisitedNodes {
+ public:
+  explicit VisitedNodes(const Graph& graph) {
+    auto& marks = thread_marks();
+    if (marks.in_use) {
+      m_fallback.emplace();
+      return;
+    }
+    marks.in_use = true;
+    if (marks.bits.size() <= graph.num_nodes()) {
+      marks.bits.resize(graph.num_nodes() + 1);
+    }
+    m_marks = &marks;
+  }
+
+  VisitedNodes(const VisitedNodes&) = delete;
+  VisitedNodes& operator=(const VisitedNodes&) = delete;
+
+  ~VisitedNodes() {
+    if (m_marks == nullptr) {
+      return;
+    }
+    for (auto id : m_marks->touched) {
+      m_marks->bits[id] = false;
+    }
+    m_marks->touched.clear();
+    m_marks->in_use = false;
+  }
+
+  // Returns whether the node was not visited yet.
+  bool insert(const Node* node) {
+    if (m_fallback) {
+      return m_fallback->emplace(node).second;
+    }
+    auto id = node->id;
+    if (m_marks->bits[id]) {
+      return false;
+    }
+    m_marks->bits[id] = true;
+    m_marks->touched.push_back(id);
+    return true;
+  }
+
+ private:
+  struct Marks {
+    std::vector<bool> bits;
+    std::vector<uint32_t> touched;
+    bool in_use{false};
+  };
+
+  static Marks& thread_marks() {
+    thread_local Marks marks;
+    return marks;
+  }
+
+  Marks* m_marks{nullptr};
+  std::optional<UnorderedSet<const Node*>> m_fallback;
+};
+
 template <typename F>
 bool all_overriding_methods_impl(const Graph& graph,
                                  const DexMethod* method,
@@ -416,12 +482,12 @@ bool all_overriding_methods_impl(const Graph& graph,
     base_type = nullptr;
   }
   if (root.is_interface) {
-    UnorderedSet<const Node*> visited{&root};
-    visited.reserve(root.children.size() * 7);
+    VisitedNodes visited(graph);
+    visited.insert(&root);
     return self_recursive_fn(
         [&](auto self, const auto& children) -> bool {
           for (const auto* node : UnorderedIterable(children)) {
-            if (!visited.emplace(node).second) {
+            if (!visited.insert(node)) {
               continue;
             }
             if (!self(self, node->children)) {
@@ -461,12 +527,12 @@ bool all_overridden_methods_impl(const Graph& graph,
                                  bool include_interfaces) {
   const Node& root = graph.get_node(method);
   if (include_interfaces) {
-    UnorderedSet<const Node*> visited{&root};
-    visited.reserve(root.parents.size() * 7);
+    VisitedNodes visited(graph);
+    visited.insert(&root);
     return self_recursive_fn(
         [&](auto self, const auto& children) -> bool {
           for (const auto* node : UnorderedIterable(children)) {
-            if (!visited.emplace(node).second) {
+            if (!visited.insert(node)) {
               continue;
             }
             if (!include_interfaces && node->is_interface) {
@@ -537,8 +603,10 @@ const Node& Graph::get_node(const DexMethod* method) const {
 }
 
 void Graph::mark_miranda(const DexMethod* method) {
-  m_nodes.update(method, [&](const DexMethod*, Node& node, bool /*exists*/) {
-    node.method = method;
+  m_nodes.update(method, [&](const DexMethod*, Node& node, bool exists) {
+    if (!exists) {
+      init_node(method, node);
+    }
     node.is_miranda = true;
   });
 }
@@ -561,7 +629,7 @@ void Graph::add_edge(const DexMethod* overridden,
   Node* overriding_node = nullptr;
   m_nodes.update(overriding, [&](const DexMethod*, Node& node, bool exists) {
     if (!exists) {
-      node.method = overriding;
+      init_node(overriding, node);
       node.is_interface = overriding_is_interface;
     }
     overriding_node = &node;
@@ -572,7 +640,7 @@ void Graph::add_edge(const DexMethod* overridden,
     if (exists) {
       always_assert(node.is_interface == overridden_is_interface);
     } else {
-      node.method = overridden;
+      init_node(overridden, node);
       node.is_interface = overridden_is_interface;
     }
     node.children.insert(overriding_node);
@@ -611,7 +679,7 @@ bool Graph::add_other_implementation_class(const DexMethod* overridden,
   bool parent_inserted = false;
   m_nodes.update(overriding, [&](const DexMethod*, Node& node, bool exists) {
     if (!exists) {
-      node.method = overriding;
+      init_node(overriding, node);
     }
     auto& oii = node.other_interface_implementations;
     if (!oii) {
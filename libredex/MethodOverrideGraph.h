@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "ConcurrentContainers.h"
 #include "DeterministicContainers.h"
 #include "DexClass.h"
@@ -126,6 +128,9 @@ struct OtherInterfaceImplementations {
  */
 struct Node {
   const DexMethod* method{nullptr};
+  // A dense id in [1, Graph::num_nodes()], assigned when the node is added to
+  // the graph. Only nodes that are not part of a graph have id 0.
+  uint32_t id{0};
   // The set of immediately overridden / implemented methods.
   UnorderedBag<Node*> parents;
   // The set of immediately overriding / implementing methods.
@@ -155,6 +160,8 @@ class Graph {
 
   const ConcurrentMap<const DexMethod*, Node>& nodes() const { return m_nodes; }
 
+  size_t num_nodes() const { return m_num_nodes.load(); }
+
   void add_edge(const DexMethod* overridden, const DexMethod* overriding);
 
   void add_edge(const DexMethod* overridden,
@@ -184,7 +191,14 @@ class Graph {
     static const Node empty_node;
     return empty_node;
   }
+  // Creates the node of `method`, within an update of m_nodes.
+  void init_node(const DexMethod* method, Node& node) {
+    node.method = method;
+    node.id = ++m_num_nodes;
+  }
+
   ConcurrentMap<const DexMethod*, Node> m_nodes;
+  std::atomic<uint32_t> m_num_nodes{0};
   bool m_has_miranda{false};
 };
 
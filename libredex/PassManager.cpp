@@ -21,13 +21,17 @@
 #include <sstream>
 #include <utility>
 
+#include <boost/functional/hash.hpp>
+
 #include "AnalysisUsage.h"
 #include "ApiLevelChecker.h"
 #include "AssetManager.h"
+#include "ChromeTraceWriter.h"
 #include "ClassChecker.h"
 #include "CommandProfiling.h"
 #include "ConfigFiles.h"
 #include "DexClass.h"
+#include "DexHasher.h"
 #include "DexStructure.h"
 #include "DexUtil.h"
 #include "GlobalConfig.h"
@@ -35,6 +39,7 @@
 #include "IRCode.h"
 #include "IRTypeChecker.h"
 #include "JemallocUtil.h"
+#include "MethodFacts.h"
 #include "MethodProfiles.h"
 #include "Native.h"
 #include "OptData.h"
@@ -53,6 +58,7 @@
 #include "ThreadPool.h"
 #include "Timer.h"
 #include "Trace.h"
+#include "TypeCheckFingerprints.h"
 #include "Walkers.h"
 
 namespace {
@@ -108,6 +114,10 @@ class CheckerConfig {
     always_assert(global_config.has_config_by_name("ir_type_checker"));
     m_config = *global_config.get_config_by_name<IRTypeCheckerConfig>(
         "ir_type_checker");
+    if (m_config.incremental && !m_disabled) {
+      m_verified_fingerprints = std::make_shared<
+          ConcurrentMap<const DexMethod*, std::optional<size_t>>>();
+    }
   }
 
   void on_input(const Scope& scope) {
@@ -248,14 +258,45 @@ class CheckerConfig {
       return code->cfg_built() ? show(code->cfg()) : show(code);
     };
 
+    // The settings that affect the outcome are part of every fingerprint.
+    size_t settings = 0;
+    boost::hash_combine(settings, m_validate_access);
+    boost::hash_combine(settings, m_config.check_no_overwrite_this);
+    boost::hash_combine(settings, m_config.verify_moves);
+    boost::hash_combine(settings, m_config.validate_invoke_super);
+    std::optional<TypeCheckFingerprints> fingerprints;
+    if (m_verified_fingerprints) {
+      fingerprints.emplace();
+    }
+    std::atomic<size_t> skipped{0};
+
     auto res =
         walk::parallel::methods<Result>(scope, [&](DexMethod* dex_method) {
+          std::optional<size_t> fingerprint;
+          if (fingerprints) {
+            fingerprint = settings;
+            boost::hash_combine(*fingerprint,
+                                fingerprints->fingerprint(dex_method));
+            if (m_verified_fingerprints->get(dex_method, std::nullopt) ==
+                fingerprint) {
+              skipped.fetch_add(1, std::memory_order_relaxed);
+              return Result();
+            }
+          }
           auto checker = run_checker(dex_method);
           if (!checker.fail()) {
+            if (fingerprint) {
+              m_verified_fingerprints->insert_or_assign(
+                  std::make_pair(dex_method, fingerprint));
+            }
             return Result();
           }
           return Result(dex_method);
         });
+    if (fingerprints) {
+      TRACE(PM, 1, "IRTypeChecker: skipped %zu unchanged methods",
+            skipped.load());
+    }
 
     if (res.errors != 0) {
       // Re-run the smallest method to produce error message.
@@ -296,6 +337,10 @@ class CheckerConfig {
   bool m_validate_access{true};
   bool m_disabled;
   IRTypeCheckerConfig m_config;
+  // Fingerprints of methods as of the last check they passed. Shared by the
+  // copies made by the literate setters, so that all runs benefit.
+  std::shared_ptr<ConcurrentMap<const DexMethod*, std::optional<size_t>>>
+      m_verified_fingerprints;
 };
 
 class CheckUniqueDeobfuscatedNames {
@@ -349,7 +394,7 @@ class CheckUniqueDeobfuscatedNames {
     });
     UnorderedMap<std::string, DexField*> field_names;
     walk::fields(scope, [&field_names, pass_name](DexField* dex_field) {
-      auto deob = dex_field->get_deobfuscated_name();
+      auto deob = dex_field->get_deobfuscated_name_or_empty_copy();
       auto it = field_names.find(deob);
       if (it != field_names.end()) {
         fprintf(stderr,
@@ -400,8 +445,9 @@ class AnalysisUsageHelper {
  public:
   using PreservedMap = UnorderedMap<AnalysisID, Pass*>;
 
-  explicit AnalysisUsageHelper(PreservedMap& m)
-      : m_preserved_analysis_passes(m) {}
+  AnalysisUsageHelper(PreservedMap& m,
+                      std::unique_ptr<MethodFactsCache>& method_facts)
+      : m_preserved_analysis_passes(m), m_method_facts(method_facts) {}
 
   void pre_pass(Pass* pass) { pass->set_analysis_usage(m_analysis_usage); }
 
@@ -409,6 +455,9 @@ class AnalysisUsageHelper {
     // Invalidate existing preserved analyses according to policy set by each
     // pass.
     m_analysis_usage.do_pass_invalidation(&m_preserved_analysis_passes);
+    if (!m_analysis_usage.preserves_all()) {
+      m_method_facts.reset();
+    }
 
     if (pass->is_analysis_pass()) {
       // If the pass is an analysis pass, preserve it.
@@ -419,6 +468,7 @@ class AnalysisUsageHelper {
  private:
   AnalysisUsage m_analysis_usage;
   PreservedMap& m_preserved_analysis_passes;
+  std::unique_ptr<MethodFactsCache>& m_method_facts;
 };
 
 class JNINativeContextHelper {
@@ -953,8 +1003,13 @@ struct JemallocStats {
                                        [[maybe_unused]] size_t run) {
 #ifdef USE_JEMALLOC
     std::string key_base = "~jemalloc.";
+    auto now = ChromeTraceWriter::clock::now();
     auto cb = [&](const char* key, uint64_t value) {
       pm->set_metric(key_base + key, value);
+      if (ChromeTraceWriter::enabled()) {
+        ChromeTraceWriter::record_counter(std::string("jemalloc.") + key,
+                                          value, now);
+      }
     };
     jemalloc_util::some_malloc_stats(cb);
 
@@ -1275,6 +1330,7 @@ class PassManager::RunPassesContext {
                        malloc_profile_pass, violations_tracking} {
     // Clear stale data. Make sure we start fresh.
     mgr.m_preserved_analysis_passes.clear();
+    mgr.m_method_facts.reset();
 
     Timer::scope("API Level Checker", [&] {
       api::LevelChecker::init(mgr.m_redex_options.min_sdk, scope);
@@ -1377,7 +1433,8 @@ class PassManager::RunPassesContext {
   void run_pass(size_t i, bool& after_interdex) {
     Pass* pass = mgr.m_activated_passes[i];
     const size_t pass_run = ++runs[pass];
-    AnalysisUsageHelper analysis_usage_helper{mgr.m_preserved_analysis_passes};
+    AnalysisUsageHelper analysis_usage_helper{mgr.m_preserved_analysis_passes,
+                                              mgr.m_method_facts};
     analysis_usage_helper.pre_pass(pass);
 
     if (!after_interdex && pass->name() == "InterDexPass") {
@@ -1430,6 +1487,11 @@ class PassManager::RunPassesContext {
 
     scoped_mem_stats.trace_log(&mgr, pass);
 
+    if (ChromeTraceWriter::enabled()) {
+      ChromeTraceWriter::record_counter("VmRSS", get_mem_stats().vm_rss,
+                                        ChromeTraceWriter::clock::now());
+    }
+
     jemalloc_stats.process_jemalloc_stats_for_pass(pass, pass_run);
 
     mgr.set_metric("~redex_context.leaked_methods", g_redex->leaked_methods());
@@ -1807,6 +1869,14 @@ PassManager::ActivatedPasses PassManager::compute_activated_passes(
   return result;
 }
 
+const MethodFactsCache& PassManager::get_method_facts(const Scope& scope) {
+  if (!m_method_facts) {
+    Timer t("Build method facts");
+    m_method_facts = std::make_unique<MethodFactsCache>(scope);
+  }
+  return *m_method_facts;
+}
+
 Pass* PassManager::find_pass(const std::string& pass_name) const {
   auto pass_it = std::find_if(
       m_activated_passes.begin(),
@@ -29,6 +29,7 @@
 
 struct ConfigFiles;
 class DexStore;
+class MethodFactsCache;
 class Pass;
 struct PassManagerConfig;
 
@@ -180,6 +181,11 @@ class PassManager {
     return nullptr;
   }
 
+  // Per-method facts (see MethodFacts.h) for `scope`, built on first use and
+  // shared by all following passes until one runs that does not preserve all
+  // analyses. Must not be called concurrently.
+  const MethodFactsCache& get_method_facts(const Scope& scope);
+
   Pass* find_pass(const std::string& pass_name) const;
 
   struct ActivatedPasses {
@@ -216,6 +222,7 @@ class PassManager {
   std::vector<Pass*> m_registered_passes;
   std::vector<Pass*> m_activated_passes;
   UnorderedMap<AnalysisID, Pass*> m_preserved_analysis_passes;
+  std::unique_ptr<MethodFactsCache> m_method_facts;
 
   // Per-pass information and metrics
   std::vector<PassManager::PassInfo> m_pass_info;
@@ -7,13 +7,16 @@
 
 #include "ProguardMap.h"
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 
 #include "Debug.h"
 #include "DexEncoding.h"
 #include "DexPosition.h"
 #include "DexUtil.h"
 #include "IRCode.h"
+#include "ReadMaybeMapped.h"
 #include "Show.h"
 #include "Timer.h"
 #include "Trace.h"
@@ -45,21 +48,25 @@ std::string convert_scalar_type(std::string_view type) {
 std::string convert_field(const std::string& cls,
                           const std::string& type,
                           const std::string& name) {
-  std::ostringstream ss;
-  ss << cls << "." << name;
+  std::string res;
+  res.reserve(cls.size() + name.size() + type.size() + 2);
+  res.append(cls).append(".").append(name);
   if (!type.empty()) {
-    ss << ":" << type;
+    res.append(":").append(type);
   }
-  return ss.str();
+  return res;
 }
 
 std::string convert_method(const std::string& cls,
                            const std::string& rtype,
                            const std::string& methodname,
                            const std::string& args) {
-  std::ostringstream ss;
-  ss << cls << "." << methodname << ":(" << args << ")" << rtype;
-  return ss.str();
+  std::string res;
+  res.reserve(cls.size() + methodname.size() + args.size() + rtype.size() +
+              4);
+  res.append(cls).append(".").append(methodname).append(":(");
+  res.append(args).append(")").append(rtype);
+  return res;
 }
 
 std::string translate_type(const std::string& type, const ProguardMap& pm) {
@@ -187,6 +194,76 @@ bool method_full_format(const char*& p, std::string& s) {
   return true;
 }
 
+// Parses a class mapping line, without applying it.
+bool class_line(const std::string& line,
+                std::string* classname,
+                std::string* newname) {
+  std::string old_name;
+  std::string new_name;
+  const auto* p = line.c_str();
+  if (!id(p, old_name)) {
+    return false;
+  }
+  if (!literal(p, " -> ")) {
+    return false;
+  }
+  if (!id(p, new_name)) {
+    return false;
+  }
+  *classname = convert_type(old_name);
+  *newname = convert_type(new_name);
+  return true;
+}
+
+// Calls fn with each line of the given text, without the trailing newline.
+// The line is copied into a reused buffer, as the parsers depend on it being
+// null-terminated.
+template <typename Fn>
+void for_each_line(std::string_view text, const Fn& fn) {
+  std::string line;
+  while (!text.empty()) {
+    auto end = text.find('\n');
+    auto len = end == std::string_view::npos ? text.size() : end;
+    auto line_len = len;
+    if (line_len > 0 && text[line_len - 1] == '\r') {
+      --line_len;
+    }
+    line.assign(text.data(), line_len);
+    fn(line);
+    text.remove_prefix(end == std::string_view::npos ? len : len + 1);
+  }
+}
+
+// Splits a mapping file into chunks that each start with a class line (or
+// with the start of the file), so that chunks can be parsed independently.
+std::vector<std::string_view> split_at_classes(std::string_view contents,
+                                               size_t target_size) {
+  std::vector<std::string_view> chunks;
+  size_t begin = 0;
+  while (begin < contents.size()) {
+    size_t end = begin + target_size;
+    // Find the next line that does not start with whitespace or a comment,
+    // which can only be a class line.
+    while (end < contents.size()) {
+      auto newline = contents.find('\n', end);
+      if (newline == std::string_view::npos) {
+        end = contents.size();
+        break;
+      }
+      end = newline + 1;
+      if (end < contents.size() &&
+          isspace(static_cast<unsigned char>(contents[end])) == 0 &&
+          contents[end] != '#') {
+        break;
+      }
+    }
+    end = std::min(end, contents.size());
+    chunks.push_back(contents.substr(begin, end - begin));
+    begin = end;
+  }
+  return chunks;
+}
+
 bool comment(const std::string& line) {
   const auto* p = line.c_str();
   whitespace(p);
@@ -225,21 +302,46 @@ bool is_maybe_proguard_generated_member(const std::string& s) {
 }
 } // namespace
 
+struct ProguardMap::ParsedMembers {
+  struct Field {
+    std::string pgold;
+    std::string pgnew;
+    std::string pgnew_notype;
+  };
+  struct Method {
+    std::string pgold;
+    std::string pgnew;
+    std::string pgnew_no_rtype;
+    std::unique_ptr<ProguardLineRange> lines;
+  };
+  std::vector<Field> fields;
+  std::vector<Method> methods;
+  // Pairs of a coalesced interface and the member that revealed it.
+  std::vector<std::pair<std::string, std::string>> coalesced_interfaces;
+};
+
 ProguardMap::ProguardMap(const std::string& filename, bool use_new_rename_map) {
   if (filename.empty()) {
     return;
   }
   Timer t("Parsing proguard map");
-  std::ifstream fp(filename);
-  always_assert_log(fp, "Can't open proguard map: %s\n", filename.c_str());
-
   if (use_new_rename_map) {
+    std::ifstream fp(filename);
+    always_assert_log(fp, "Can't open proguard map: %s\n", filename.c_str());
     parse_full_map(fp);
   } else {
-    parse_proguard_map(fp);
+    redex::read_file_with_contents(filename, [&](const char* data, size_t size) {
+      parse_proguard_map(std::string_view(data, size));
+    });
   }
 }
 
+ProguardMap::ProguardMap(std::istream& is) {
+  std::string contents{std::istreambuf_iterator<char>(is),
+                       std::istreambuf_iterator<char>()};
+  parse_proguard_map(contents);
+}
+
 std::string ProguardMap::translate_class(const std::string& cls) const {
   return find_or_same(cls, m_classMap);
 }
@@ -298,29 +400,93 @@ ProguardLineRangeVector& ProguardMap::method_lines(
       str_copy(pg_impl::lines_key(obfuscated_method)));
 }
 
-void ProguardMap::parse_proguard_map(std::istream& fp) {
-  std::string line;
-  while (std::getline(fp, line)) {
-    parse_class(line);
+void ProguardMap::parse_proguard_map(std::string_view contents) {
+  // Members are mapped to names using the translated names of their types, so
+  // all classes need to be known first. Both passes run over independent
+  // chunks in parallel, and their results are applied in file order, exactly
+  // as a sequential parse would.
+  constexpr size_t kMinChunkSize = 1 << 20;
+  auto num_threads = redex_parallel::default_num_threads();
+  auto chunks = split_at_classes(
+      contents, std::max(kMinChunkSize, contents.size() / (num_threads * 4)));
+  num_threads = std::min(num_threads, chunks.size());
+
+  std::vector<std::vector<std::pair<std::string, std::string>>> classes(
+      chunks.size());
+  workqueue_run_for<size_t>(
+      0, chunks.size(),
+      [&](size_t i) { parse_classes(chunks[i], &classes[i]); }, num_threads);
+  for (auto& chunk_classes : classes) {
+    for (auto& [cls, new_cls] : chunk_classes) {
+      m_obfClassMap[new_cls] = cls;
+      m_classMap[std::move(cls)] = std::move(new_cls);
+    }
   }
-  fp.clear();
-  fp.seekg(0);
-  assert_log(!fp.fail(), "Can't use ProguardMap with non-seekable stream");
-  while (std::getline(fp, line)) {
-    if (parse_class(line)) {
-      continue;
+  classes.clear();
+
+  std::vector<ParsedMembers> members(chunks.size());
+  workqueue_run_for<size_t>(
+      0, chunks.size(),
+      [&](size_t i) { parse_members(chunks[i], &members[i]); }, num_threads);
+  for (auto& chunk_members : members) {
+    apply_members(std::move(chunk_members));
+  }
+}
+
+void ProguardMap::parse_classes(
+    std::string_view chunk,
+    std::vector<std::pair<std::string, std::string>>* classes) const {
+  for_each_line(chunk, [&](const std::string& line) {
+    std::string cls;
+    std::string new_cls;
+    if (class_line(line, &cls, &new_cls)) {
+      classes->emplace_back(std::move(cls), std::move(new_cls));
     }
-    if (parse_field(line)) {
-      continue;
+  });
+}
+
+void ProguardMap::parse_members(std::string_view chunk,
+                                ParsedMembers* members) const {
+  std::string cls;
+  std::string new_cls;
+  for_each_line(chunk, [&](const std::string& line) {
+    if (class_line(line, &cls, &new_cls)) {
+      return;
     }
-    if (parse_method(line)) {
-      continue;
+    if (parse_field(line, cls, new_cls, members)) {
+      return;
+    }
+    if (parse_method(line, cls, new_cls, members)) {
+      return;
     }
     if (comment(line)) {
-      continue;
+      return;
     }
     not_reached_log("Bogus line encountered in proguard map: %s\n",
                     line.c_str());
+  });
+}
+
+void ProguardMap::apply_members(ParsedMembers&& members) {
+  for (auto& [ctype, pgold] : members.coalesced_interfaces) {
+    fprintf(stderr,
+            "Type '%s' is touched by Proguard in '%s'\n",
+            ctype.c_str(),
+            pgold.c_str());
+    m_pg_coalesced_interfaces.insert(std::move(ctype));
+  }
+  for (auto& field : members.fields) {
+    m_fieldMap[field.pgold] = field.pgnew;
+    m_obfUntypedFieldMap[std::move(field.pgnew_notype)] = field.pgold;
+    m_obfFieldMap[std::move(field.pgnew)] = std::move(field.pgold);
+  }
+  for (auto& method : members.methods) {
+    m_methodMap[method.pgold] = method.pgnew;
+    m_obfUntypedMethodMap[std::move(method.pgnew_no_rtype)] = method.pgold;
+    method.lines->original_name = method.pgold;
+    m_obfMethodLinesMap[str_copy(pg_impl::lines_key(method.pgnew))].push_back(
+        std::move(method.lines));
+    m_obfMethodMap[std::move(method.pgnew)] = std::move(method.pgold);
   }
 }
 
@@ -445,27 +611,10 @@ bool ProguardMap::parse_method_full_format(const std::string& line) {
   return true;
 }
 
-bool ProguardMap::parse_class(const std::string& line) {
-  std::string classname;
-  std::string newname;
-  const auto* p = line.c_str();
-  if (!id(p, classname)) {
-    return false;
-  }
-  if (!literal(p, " -> ")) {
-    return false;
-  }
-  if (!id(p, newname)) {
-    return false;
-  }
-  m_currClass = convert_type(classname);
-  m_currNewClass = convert_type(newname);
-  m_classMap[m_currClass] = m_currNewClass;
-  m_obfClassMap[m_currNewClass] = m_currClass;
-  return true;
-}
-
-bool ProguardMap::parse_field(const std::string& line) {
+bool ProguardMap::parse_field(const std::string& line,
+                              const std::string& cls,
+                              const std::string& new_cls,
+                              ParsedMembers* members) const {
   std::string type;
   std::string fieldname;
   std::string newname;
@@ -488,27 +637,25 @@ bool ProguardMap::parse_field(const std::string& line) {
 
   auto ctype = convert_type(type);
   auto xtype = translate_type(ctype, *this);
-  auto pgnew = convert_field(m_currNewClass, xtype, newname);
-  auto pgnew_notype = convert_field(m_currNewClass, "", newname);
-  auto pgold = convert_field(m_currClass, ctype, fieldname);
+  auto pgnew = convert_field(new_cls, xtype, newname);
+  auto pgnew_notype = convert_field(new_cls, "", newname);
+  auto pgold = convert_field(cls, ctype, fieldname);
   // Record interfaces that are coalesced by Proguard.
   if (ctype[0] == 'L' && is_maybe_proguard_generated_member(fieldname)) {
-    fprintf(stderr,
-            "Type '%s' is touched by Proguard in '%s'\n",
-            ctype.c_str(),
-            pgold.c_str());
-    m_pg_coalesced_interfaces.insert(ctype);
+    members->coalesced_interfaces.emplace_back(ctype, pgold);
   }
-  m_fieldMap[pgold] = pgnew;
-  m_obfFieldMap[pgnew] = pgold;
-  m_obfUntypedFieldMap[pgnew_notype] = pgold;
+  members->fields.push_back({std::move(pgold), std::move(pgnew),
+                             std::move(pgnew_notype)});
   return true;
 }
 
-bool ProguardMap::parse_method(const std::string& line) {
+bool ProguardMap::parse_method(const std::string& line,
+                               const std::string& cls,
+                               const std::string& new_cls,
+                               ParsedMembers* members) const {
   std::string type;
   std::string methodname;
-  std::string classname = m_currClass;
+  std::string classname = cls;
   std::string old_args;
   std::string new_args;
   std::string newname;
@@ -559,14 +706,10 @@ bool ProguardMap::parse_method(const std::string& line) {
   auto old_rtype = convert_type(type);
   auto new_rtype = translate_type(old_rtype, *this);
   auto pgold = convert_method(classname, old_rtype, methodname, old_args);
-  auto pgnew = convert_method(m_currNewClass, new_rtype, newname, new_args);
-  auto pgnew_no_rtype = convert_method(m_currNewClass, "", newname, new_args);
-  m_methodMap[pgold] = pgnew;
-  m_obfMethodMap[pgnew] = pgold;
-  m_obfUntypedMethodMap[pgnew_no_rtype] = pgold;
-  lines->original_name = pgold;
-  m_obfMethodLinesMap[str_copy(pg_impl::lines_key(pgnew))].push_back(
-      std::move(lines));
+  auto pgnew = convert_method(new_cls, new_rtype, newname, new_args);
+  auto pgnew_no_rtype = convert_method(new_cls, "", newname, new_args);
+  members->methods.push_back({std::move(pgold), std::move(pgnew),
+                              std::move(pgnew_no_rtype), std::move(lines)});
   return true;
 }
 
@@ -10,6 +10,9 @@
 #include <cstddef>
 #include <iosfwd>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "DeterministicContainers.h"
 #include "DexClass.h"
@@ -52,7 +55,7 @@ struct ProguardMap {
   /**
    * Construct map from a given stream.
    */
-  explicit ProguardMap(std::istream& is) { parse_proguard_map(is); }
+  explicit ProguardMap(std::istream& is);
 
   /**
    * Translate un-obfuscated class name to obfuscated name.
@@ -111,12 +114,25 @@ struct ProguardMap {
   }
 
  private:
-  void parse_proguard_map(std::istream& fp);
+  struct ParsedMembers;
+
+  void parse_proguard_map(std::string_view contents);
   void parse_full_map(std::istream& fp);
 
-  bool parse_class(const std::string& line);
-  bool parse_field(const std::string& line);
-  bool parse_method(const std::string& line);
+  void parse_classes(std::string_view chunk,
+                     std::vector<std::pair<std::string, std::string>>* classes)
+      const;
+  void parse_members(std::string_view chunk, ParsedMembers* members) const;
+  void apply_members(ParsedMembers&& members);
+
+  bool parse_field(const std::string& line,
+                   const std::string& cls,
+                   const std::string& new_cls,
+                   ParsedMembers* members) const;
+  bool parse_method(const std::string& line,
+                    const std::string& cls,
+                    const std::string& new_cls,
+                    ParsedMembers* members) const;
 
   bool parse_class_full_format(const std::string& line);
   bool parse_store_full_format(const std::string& line);
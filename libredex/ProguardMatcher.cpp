@@ -538,12 +538,12 @@ bool KeepRuleMatcher::has_annotation(const DexMember* member,
 
 // From a fully qualified descriptor for a field, extract just the
 // name of the field which occurs between the ;. and : characters.
-const char* extract_field_name_cstr(const std::string& qualified_fieldname) {
+std::string_view extract_field_name(std::string_view qualified_fieldname) {
   auto p = qualified_fieldname.find(";.");
-  if (p == std::string::npos) {
-    return qualified_fieldname.c_str();
+  if (p == std::string_view::npos) {
+    return qualified_fieldname;
   }
-  return qualified_fieldname.c_str() + p + 2;
+  return qualified_fieldname.substr(p + 2);
 }
 
 const char* extract_method_name_and_type_cstr(
@@ -569,9 +569,9 @@ bool KeepRuleMatcher::field_level_match(
     return false;
   }
   // Match field name against regex.
-  const auto* dequalified_name_cstr =
-      extract_field_name_cstr(field->get_deobfuscated_name());
-  return boost::regex_match(dequalified_name_cstr, fieldname_regex);
+  auto dequalified_name = extract_field_name(field->get_deobfuscated_name());
+  return boost::regex_match(dequalified_name.begin(), dequalified_name.end(),
+                            fieldname_regex);
 }
 
 template <class Container>
@@ -7,6 +7,7 @@
 
 #include "RedexResources.h"
 
+#include <algorithm>
 #include <array>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/filesystem/operations.hpp>
@@ -40,9 +41,11 @@ namespace {
 constexpr size_t MIN_CLASSNAME_LENGTH = 10;
 constexpr size_t MAX_CLASSNAME_LENGTH = 500;
 
-constexpr decltype(redex_parallel::default_num_threads()) kReadXMLThreads = 4u;
-constexpr decltype(redex_parallel::default_num_threads()) kReadNativeThreads =
-    2u;
+// Parsing a binary xml file is cheap compared to the cost of handing it to a
+// thread, so each thread should get a decent amount of them.
+constexpr size_t kMinXMLFilesPerThread = 64;
+// Native libraries are large, a single one is worth its own thread.
+constexpr size_t kMinNativeFilesPerThread = 1;
 
 using path_t = boost::filesystem::path;
 using dir_iterator = boost::filesystem::directory_iterator;
@@ -215,84 +218,101 @@ std::string configs_to_string(
   return s.str();
 }
 
+namespace resources {
+size_t get_read_threads(size_t num_files, size_t min_files_per_thread) {
+  always_assert(min_files_per_thread > 0);
+  size_t by_work =
+      (num_files + min_files_per_thread - 1) / min_files_per_thread;
+  return std::max<size_t>(
+      1, std::min(redex_parallel::default_num_threads(), by_work));
+}
+} // namespace resources
+
 namespace {
-template <typename Fn>
-void find_resource_xml_files(const std::string& dir,
-                             const std::vector<std::string>& skip_dirs_prefixes,
-                             Fn handler) {
-  path_t res(dir);
-  if (exists(res) && is_directory(res)) {
-    for (auto it = dir_iterator(res); it != dir_iterator(); ++it) {
-      auto const& entry = *it;
-      const path_t& entry_path = entry.path();
+void collect_xml_files_info(const path_t& res,
+                            std::vector<resources::ResourceFileInfo>* out) {
+  if (!exists(res) || !is_directory(res)) {
+    return;
+  }
+  for (auto it = rdir_iterator(res); it != rdir_iterator(); ++it) {
+    const path_t& entry_path = it->path();
+    if (!is_regular_file(entry_path) ||
+        !entry_path.string().ends_with(".xml")) {
+      continue;
+    }
+    resources::ResourceFileInfo info;
+    info.path = entry_path.string();
+    // Depth 0 is a file directly in res, depth 1 is res/<type>/file.xml.
+    auto depth = it.depth();
+    info.shallow = depth <= 1;
+    if (depth > 0) {
+      auto type_dir = entry_path.parent_path();
+      for (auto d = depth; d > 1; d--) {
+        type_dir = type_dir.parent_path();
+      }
+      info.type_dir = type_dir.filename().string();
+    }
+    info.size = file_size(entry_path);
+    out->emplace_back(std::move(info));
+  }
+}
 
-      if (is_directory(entry_path)) {
-        auto matches_prefix = [&skip_dirs_prefixes](const auto& p) {
-          const auto& str = p.string();
-          for (const auto& prefix : skip_dirs_prefixes) {
-            if (str.find(prefix) == 0) {
-              return true;
-            }
-          }
-          return false;
-        };
-        if (matches_prefix(entry_path.filename())) {
-          continue;
-        }
+// Larger files first, so that stragglers do not hold up the end of a scan.
+template <typename T>
+void sort_by_size_descending(std::vector<T>* files) {
+  std::sort(files->begin(), files->end(), [](const auto& a, const auto& b) {
+    if (a.size != b.size) {
+      return a.size > b.size;
+    }
+    return a.path < b.path;
+  });
+}
 
-        for (auto lit = dir_iterator(entry_path); lit != dir_iterator();
-             ++lit) {
-          const path_t& resource_path = lit->path();
-          if (is_regular_file(resource_path) &&
-              resource_path.string().ends_with(".xml")) {
-            handler(resource_path.string());
-          }
-        }
-      } else {
-        // In case input APK has resource file path changed and not in usual
-        // format.
-        // TODO(T126661220): this disabled performance improvement to read less
-        // resource files, it would be better if we have mapping file to map
-        // back resource file names.
-        if (is_regular_file(entry_path) &&
-            entry_path.string().ends_with(".xml")) {
-          handler(entry_path.string());
-        }
-      }
+bool matches_any_prefix(const std::string& str,
+                        const std::vector<std::string>& prefixes) {
+  for (const auto& prefix : prefixes) {
+    if (str.starts_with(prefix)) {
+      return true;
     }
   }
+  return false;
 }
 } // namespace
 
+const std::vector<resources::ResourceFileInfo>&
+AndroidResources::get_res_xml_files() {
+  if (!m_res_xml_files) {
+    std::vector<resources::ResourceFileInfo> files;
+    for (const auto& dir : find_res_directories()) {
+      TRACE(RES, 9, "Scanning %s for xml files", dir.c_str());
+      collect_xml_files_info(path_t(dir), &files);
+    }
+    sort_by_size_descending(&files);
+    m_res_xml_files = std::move(files);
+  }
+  return *m_res_xml_files;
+}
+
 void AndroidResources::collect_layout_classes_and_attributes(
     const UnorderedSet<std::string>& attributes_to_read,
     UnorderedSet<std::string>* out_classes,
     std::unordered_multimap<std::string, std::string>* out_attributes) {
   auto res_table = load_res_table();
   auto collect_fn = [&](const std::vector<std::string>& skip_dirs_prefixes) {
+    std::vector<std::string> files;
+    for (const auto& info : get_res_xml_files()) {
+      if (info.shallow &&
+          !matches_any_prefix(info.type_dir, skip_dirs_prefixes)) {
+        files.push_back(info.path);
+      }
+    }
+
     std::mutex out_mutex;
     resources::StringOrReferenceSet classes;
     std::unordered_multimap<std::string, resources::StringOrReference>
         attributes;
     workqueue_run<std::string>(
-        [&](sparta::WorkerState<std::string>* worker_state,
-            const std::string& input) {
-          if (input.empty()) {
-            // Dispatcher, find files and create tasks.
-            auto directories = find_res_directories();
-            for (const auto& dir : directories) {
-              TRACE(RES, 9,
-                    "Scanning %s for xml files for classes and attributes",
-                    dir.c_str());
-              find_resource_xml_files(dir, skip_dirs_prefixes,
-                                      [&](const std::string& file) {
-                                        worker_state->push_task(file);
-                                      });
-            }
-
-            return;
-          }
-
+        [&](const std::string& input) {
           resources::StringOrReferenceSet local_classes;
           std::unordered_multimap<std::string, resources::StringOrReference>
               local_attributes;
@@ -305,9 +325,8 @@ void AndroidResources::collect_layout_classes_and_attributes(
             attributes.insert(local_attributes.begin(), local_attributes.end());
           }
         },
-        std::vector<std::string>{""},
-        std::min(redex_parallel::default_num_threads(), kReadXMLThreads),
-        /*push_tasks_while_running=*/true);
+        files,
+        resources::get_read_threads(files.size(), kMinXMLFilesPerThread));
 
     // Resolve references that were encountered while reading xml files
     for (const auto& val : UnorderedIterable(classes)) {
@@ -348,24 +367,16 @@ void AndroidResources::collect_layout_classes_and_attributes(
 
 void AndroidResources::collect_xml_attribute_string_values(
     UnorderedSet<std::string>* out) {
+  std::vector<std::string> files;
+  for (const auto& info : get_res_xml_files()) {
+    if (info.shallow) {
+      files.push_back(info.path);
+    }
+  }
+
   std::mutex out_mutex;
   workqueue_run<std::string>(
-      [&](sparta::WorkerState<std::string>* worker_state,
-          const std::string& input) {
-        if (input.empty()) {
-          // Dispatcher, find files and create tasks.
-          auto directories = find_res_directories();
-          for (const auto& dir : directories) {
-            TRACE(RES, 9, "Scanning %s for xml files for attribute values",
-                  dir.c_str());
-            find_resource_xml_files(dir, {}, [&](const std::string& file) {
-              worker_state->push_task(file);
-            });
-          }
-
-          return;
-        }
-
+      [&](const std::string& input) {
         UnorderedSet<std::string> local_out_values;
         collect_xml_attribute_string_values_for_file(input, &local_out_values);
         if (!local_out_values.empty()) {
@@ -374,47 +385,43 @@ void AndroidResources::collect_xml_attribute_string_values(
           insert_unordered_iterable(*out, local_out_values);
         }
       },
-      std::vector<std::string>{""},
-      std::min(redex_parallel::default_num_threads(), kReadXMLThreads),
-      /*push_tasks_while_running=*/true);
+      files,
+      resources::get_read_threads(files.size(), kMinXMLFilesPerThread));
 }
 
 void AndroidResources::rename_classes_in_layouts(
     const std::map<std::string, std::string>& rename_map) {
+  std::vector<std::string> files;
+  for (const auto& info : get_res_xml_files()) {
+    if (!is_raw_resource(info.path)) {
+      files.push_back(info.path);
+    }
+  }
+
   workqueue_run<std::string>(
-      [&](sparta::WorkerState<std::string>* worker_state,
-          const std::string& input) {
-        if (input.empty()) {
-          // Dispatcher, find files and create tasks.
-          auto directories = find_res_directories();
-          for (const auto& dir : directories) {
-            auto xml_files = get_xml_files(dir);
-            for (const auto& path : UnorderedIterable(xml_files)) {
-              if (!is_raw_resource(path)) {
-                worker_state->push_task(path);
-              }
-            }
-          }
-          return;
-        }
+      [&](const std::string& input) {
         size_t num_renamed = 0;
         TRACE(RES, 3, "Begin rename Views in layout %s", input.c_str());
         bool result = rename_classes_in_layout(input, rename_map, &num_renamed);
         TRACE(RES, 3, "%sRenamed %zu class names in file %s",
               (result ? "" : "FAILED: "), num_renamed, input.c_str());
       },
-      std::vector<std::string>{""},
-      std::min(redex_parallel::default_num_threads(), kReadXMLThreads),
-      /*push_tasks_while_running=*/true);
+      files,
+      resources::get_read_threads(files.size(), kMinXMLFilesPerThread));
 }
 
 namespace {
 
+struct NativeLibraryFile {
+  std::string path;
+  uint64_t size;
+};
+
 /**
  * Return a list of all the .so files in /lib
  */
-template <typename Fn>
-void find_native_library_files(const std::string& lib_root, Fn handler) {
+void find_native_library_files(const std::string& lib_root,
+                               std::vector<NativeLibraryFile>* out) {
   std::string library_extension(".so");
 
   path_t lib(lib_root);
@@ -426,7 +433,7 @@ void find_native_library_files(const std::string& lib_root, Fn handler) {
       if (is_regular_file(entry_path) &&
           entry_path.filename().string().ends_with(library_extension)) {
         TRACE(RES, 9, "Checking lib: %s", entry_path.string().c_str());
-        handler(entry_path.string());
+        out->push_back({entry_path.string(), file_size(entry_path)});
       }
     }
   }
@@ -438,24 +445,22 @@ void find_native_library_files(const std::string& lib_root, Fn handler) {
  * Return all potential java class names located in native libraries.
  */
 UnorderedSet<std::string> AndroidResources::get_native_classes() {
+  std::vector<NativeLibraryFile> libs;
+  for (const auto& dir : find_lib_directories()) {
+    TRACE(RES, 9, "Scanning %s for so files for class names", dir.c_str());
+    find_native_library_files(dir, &libs);
+  }
+  sort_by_size_descending(&libs);
+  std::vector<std::string> files;
+  files.reserve(libs.size());
+  for (auto& lib : libs) {
+    files.push_back(std::move(lib.path));
+  }
+
   std::mutex out_mutex;
   UnorderedSet<std::string> all_classes;
   workqueue_run<std::string>(
-      [&](sparta::WorkerState<std::string>* worker_state,
-          const std::string& input) {
-        if (input.empty()) {
-          // Dispatcher, find files and create tasks.
-          auto directories = find_lib_directories();
-          for (const auto& dir : directories) {
-            TRACE(RES, 9, "Scanning %s for so files for class names",
-                  dir.c_str());
-            find_native_library_files(dir, [&](const std::string& file) {
-              worker_state->push_task(file);
-            });
-          }
-          return;
-        }
-
+      [&](const std::string& input) {
         redex::read_file_with_contents(
             input,
             [&](const char* data, size_t size) {
@@ -469,9 +474,8 @@ UnorderedSet<std::string> AndroidResources::get_native_classes() {
             },
             static_cast<size_t>(64 * 1024));
       },
-      std::vector<std::string>{""},
-      std::min(redex_parallel::default_num_threads(), kReadNativeThreads),
-      /*push_tasks_while_running=*/true);
+      files,
+      resources::get_read_threads(files.size(), kMinNativeFilesPerThread));
   return all_classes;
 }
 
@@ -493,26 +497,23 @@ void AndroidResources::finalize_bundle_config(const ResourceConfig& config) {
 
 UnorderedSet<std::string> AndroidResources::get_all_keep_resources() {
   UnorderedSet<std::string> all_keep_resources;
-  auto directories = find_res_directories();
-  for (const auto& dir : directories) {
-    auto xml_files = get_xml_files(dir);
-    for (const auto& path : UnorderedIterable(xml_files)) {
-      if (!is_raw_resource(path)) {
-        continue;
-      }
+  for (const auto& info : get_res_xml_files()) {
+    const auto& path = info.path;
+    if (!is_raw_resource(path)) {
+      continue;
+    }
 
-      auto resource_names = resources::parse_keep_xml_file(path);
-      insert_unordered_iterable(all_keep_resources, resource_names);
-
-      if (!resource_names.empty() && traceEnabled(RES, 1)) {
-        auto iterable_resource_names = UnorderedIterable(resource_names);
-        std::string resources_str = boost::algorithm::join(
-            std::vector<std::string>(iterable_resource_names.begin(),
-                                     iterable_resource_names.end()),
-            ", ");
-        TRACE(RES, 1, "Resources kept from file %s: %s", path.c_str(),
-              resources_str.c_str());
-      }
+    auto resource_names = resources::parse_keep_xml_file(path);
+    insert_unordered_iterable(all_keep_resources, resource_names);
+
+    if (!resource_names.empty() && traceEnabled(RES, 1)) {
+      auto iterable_resource_names = UnorderedIterable(resource_names);
+      std::string resources_str = boost::algorithm::join(
+          std::vector<std::string>(iterable_resource_names.begin(),
+                                   iterable_resource_names.end()),
+          ", ");
+      TRACE(RES, 1, "Resources kept from file %s: %s", path.c_str(),
+            resources_str.c_str());
     }
   }
   return all_keep_resources;
@@ -320,6 +320,23 @@ std::string convert_utf8_to_mutf8(std::u8string_view input);
 void resources_inlining_find_refs(
     const UnorderedMap<uint32_t, uint32_t>& past_refs,
     UnorderedMap<uint32_t, resources::InlinableValue>* inlinable_resources);
+
+// An .xml file found under one of the res directories of an app.
+struct ResourceFileInfo {
+  std::string path;
+  // Name of the directory directly below the res directory holding the file,
+  // i.e. "layout-v21". Empty for files placed directly in the res directory.
+  std::string type_dir;
+  // Whether the file is at most one level below the res directory, which is
+  // where aapt places compiled resources.
+  bool shallow{false};
+  uint64_t size{0};
+};
+
+// Number of threads to use for reading num_files resource files. Scales with
+// the available cores, but never so far that a thread would get fewer than
+// min_files_per_thread files, as thread startup then outweighs the work.
+size_t get_read_threads(size_t num_files, size_t min_files_per_thread);
 } // namespace resources
 
 /*
@@ -664,6 +681,11 @@ class AndroidResources {
   virtual std::vector<std::string> find_res_directories() = 0;
   virtual std::vector<std::string> find_lib_directories() = 0;
 
+  // All .xml files below find_res_directories(), largest first. Built on first
+  // use and shared by the layout, attribute, rename and keep scans so that the
+  // file system is walked once per instance.
+  const std::vector<resources::ResourceFileInfo>& get_res_xml_files();
+
   // Mutate the given file based on the rename map, returning whether or not it
   // worked with some potentially meaningless out params for size metrics.
   virtual bool rename_classes_in_layout(
@@ -672,6 +694,9 @@ class AndroidResources {
       size_t* out_num_renamed) = 0;
 
   const std::string& m_directory;
+
+ private:
+  std::optional<std::vector<resources::ResourceFileInfo>> m_res_xml_files;
 };
 
 std::unique_ptr<AndroidResources> create_resource_reader(
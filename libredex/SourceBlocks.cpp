@@ -800,7 +800,7 @@ InsertResult insert_source_blocks(DexMethod* method,
 }
 
 static std::string get_serialized_idom_map(ControlFlowGraph* cfg) {
-  auto doms = dominators::SimpleFastDominators<cfg::GraphInterface>(*cfg);
+  const auto& doms = cfg->get_dominators();
   std::stringstream ss_idom_map;
   auto cfg_blocks = cfg->blocks();
   bool wrote_first_idom_map_elem = false;
@@ -7,23 +7,105 @@
 
 #pragma once
 
+#include <cstring>
+#include <fstream>
 #include <istream>
 #include <ostream>
+#include <sstream>
+#include <string_view>
 
 #include <sparta/S_Expression.h>
 
+#include "ConcurrentContainers.h"
 #include "DexClass.h"
+#include "ReadMaybeMapped.h"
 #include "Show.h"
 #include "Trace.h"
+#include "WorkQueue.h"
 
 /*
  * This module serves to (de)serialize maps of DexMethods to summary objects
  * of any type, which is useful for the analysis of methods external to the
  * APK.
+ *
+ * There are two formats. The text format has one s-expression per method and
+ * is meant for reading and debugging. The binary format is meant for large
+ * summary sets:
+ *
+ *   magic (4 bytes), version (4 bytes)
+ *   string_count (4 bytes), then per string: length (4 bytes), bytes
+ *   entry_count (4 bytes), then per entry: method string id (4 bytes),
+ *                                          summary string id (4 bytes)
+ *
+ * Methods are stored as full descriptors, summaries as the text of their
+ * s-expressions. Many methods share a summary, and each distinct summary is
+ * stored, and parsed on load, only once.
  */
 
 namespace summary_serialization {
 
+constexpr uint32_t kBinaryMagic = 0x5253554d; // "MUSR" when read as bytes
+constexpr uint32_t kBinaryVersion = 1;
+
+namespace detail {
+
+// Check that we are indeed specifying the behavior of an external method.
+// I'm not really sure what happens when a dex re-defines a system class --
+// I suspect it just gets ignored -- but I'm going to be conservative. Note
+// also that we are checking is_external on the class rather than the method
+// because not every external method has a defined stub (e.g. if it is
+// implicitly defined due to inheriting from another method, like how
+// ArrayList.equals() inherits from Object.equals()).
+inline bool should_load(const DexMethodRef* dex_method, bool no_load_external) {
+  auto* cls = type_class(dex_method->get_class());
+  if (cls == nullptr || (no_load_external && !cls->is_external())) {
+    TRACE(LIB, 1, "Found a summary for non-external method '%s', ignoring",
+          SHOW(dex_method));
+    return false;
+  }
+  return true;
+}
+
+template <typename V>
+void add(UnorderedMap<const DexMethodRef*, V>* map,
+         const DexMethodRef* dex_method,
+         V v) {
+  auto it = map->find(dex_method);
+  if (it == map->end()) {
+    map->emplace(dex_method, std::move(v));
+  } else {
+    fprintf(stderr, "Collision on method %s\n", SHOW(dex_method));
+  }
+}
+
+inline void write_u32(std::ostream& output, uint32_t value) {
+  output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads from the binary format in place.
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::string_view data) : m_data(data) {}
+
+  uint32_t u32() {
+    uint32_t value;
+    std::memcpy(&value, bytes(sizeof(value)).data(), sizeof(value));
+    return value;
+  }
+
+  std::string_view bytes(size_t n) {
+    always_assert_log(n <= m_data.size(), "Truncated summary file");
+    auto res = m_data.substr(0, n);
+    m_data.remove_prefix(n);
+    return res;
+  }
+
+ private:
+  std::string_view m_data;
+};
+
+} // namespace detail
+
 // It's important that we print an ordered map so our output is deterministic --
 // good for build caching.
 template <typename V>
@@ -57,29 +139,132 @@ size_t read(std::istream& input,
     if (dex_method == nullptr) {
       continue;
     }
-    // Check that we are indeed specifying the behavior of an external method.
-    // I'm not really sure what happens when a dex re-defines a system class --
-    // I suspect it just gets ignored -- but I'm going to be conservative. Note
-    // also that we are checking is_external on the class rather than the method
-    // because not every external method has a defined stub (e.g. if it is
-    // implicitly defined due to inheriting from another method, like how
-    // ArrayList.equals() inherits from Object.equals()).
-    auto* cls = type_class(dex_method->get_class());
-    if (cls == nullptr || (no_load_external && !cls->is_external())) {
-      TRACE(LIB, 1, "Found a summary for non-external method '%s', ignoring",
-            SHOW(dex_method));
+    if (!detail::should_load(dex_method, no_load_external)) {
       continue;
     }
-    auto v = V::from_s_expr(expr[1]);
-    auto it = map->find(dex_method);
-    if (it == map->end()) {
-      map->emplace(dex_method, v);
-    } else {
-      fprintf(stderr, "Collision on method %s\n", SHOW(dex_method));
+    detail::add(map, dex_method, V::from_s_expr(expr[1]));
+    ++load_count;
+  }
+  return load_count;
+}
+
+template <typename V>
+void print_binary(
+    std::ostream& output,
+    const std::map<const DexMethodRef*, V, dexmethods_comparator>& map) {
+  std::vector<std::string> strings;
+  UnorderedMap<std::string, uint32_t> string_ids;
+  auto intern = [&](std::string str) {
+    auto [it, emplaced] = string_ids.emplace(str, strings.size());
+    if (emplaced) {
+      strings.push_back(std::move(str));
+    }
+    return it->second;
+  };
+  std::vector<std::pair<uint32_t, uint32_t>> entries;
+  entries.reserve(map.size());
+  for (const auto& pair : map) {
+    auto method_id = intern(show(pair.first));
+    entries.emplace_back(method_id, intern(to_s_expr(pair.second).str()));
+  }
+
+  detail::write_u32(output, kBinaryMagic);
+  detail::write_u32(output, kBinaryVersion);
+  detail::write_u32(output, strings.size());
+  for (const auto& str : strings) {
+    detail::write_u32(output, str.size());
+    output.write(str.data(), static_cast<std::streamsize>(str.size()));
+  }
+  detail::write_u32(output, entries.size());
+  for (auto [method_id, summary_id] : entries) {
+    detail::write_u32(output, method_id);
+    detail::write_u32(output, summary_id);
+  }
+}
+
+inline bool is_binary(std::string_view data) {
+  if (data.size() < sizeof(kBinaryMagic)) {
+    return false;
+  }
+  return detail::BinaryReader(data).u32() == kBinaryMagic;
+}
+
+// Reads the binary format in place. Methods are resolved, and distinct
+// summaries parsed, in parallel.
+template <typename V>
+size_t read_binary(std::string_view data,
+                   UnorderedMap<const DexMethodRef*, V>* map,
+                   bool no_load_external = true) {
+  detail::BinaryReader reader(data);
+  always_assert_log(reader.u32() == kBinaryMagic, "Not a binary summary file");
+  auto version = reader.u32();
+  always_assert_log(version == kBinaryVersion,
+                    "Unsupported summary file version %u", version);
+  std::vector<std::string_view> strings(reader.u32());
+  for (auto& str : strings) {
+    str = reader.bytes(reader.u32());
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> entries(reader.u32());
+  for (auto& [method_id, summary_id] : entries) {
+    method_id = reader.u32();
+    summary_id = reader.u32();
+    always_assert_log(method_id < strings.size() && summary_id < strings.size(),
+                      "Invalid string id in summary file");
+  }
+
+  std::vector<DexMethodRef*> methods(entries.size());
+  InsertOnlyConcurrentMap<uint32_t, V> summaries;
+  workqueue_run_for<size_t>(0, entries.size(), [&](size_t i) {
+    auto [method_id, summary_id] = entries[i];
+    auto* dex_method = DexMethod::get_method(strings[method_id]);
+    if (dex_method == nullptr ||
+        !detail::should_load(dex_method, no_load_external)) {
+      return;
+    }
+    methods[i] = dex_method;
+    summaries.get_or_create_and_assert_equal(summary_id, [&](uint32_t id) {
+      std::istringstream input{std::string(strings[id])};
+      sparta::s_expr_istream s_expr_input(input);
+      sparta::s_expr expr;
+      s_expr_input >> expr;
+      always_assert_log(!s_expr_input.fail(), "%s\n",
+                        s_expr_input.what().c_str());
+      return V::from_s_expr(expr);
+    });
+  });
+
+  size_t load_count{0};
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (methods[i] == nullptr) {
+      continue;
     }
+    detail::add(map, methods[i], summaries.at(entries[i].second));
     ++load_count;
   }
   return load_count;
 }
 
+// Reads a summary file in either format.
+template <typename V>
+size_t read_file(const std::string& path,
+                 UnorderedMap<const DexMethodRef*, V>* map,
+                 bool no_load_external = true) {
+  std::ifstream input(path, std::ios::binary);
+  always_assert_log(input, "Can't open summary file: %s", path.c_str());
+  char magic[sizeof(kBinaryMagic)] = {};
+  input.read(magic, sizeof(magic));
+  if (!is_binary(std::string_view(magic, input.gcount()))) {
+    input.clear();
+    input.seekg(0);
+    return read(input, map, no_load_external);
+  }
+  input.close();
+  size_t load_count{0};
+  redex::read_file_with_contents(path, [&](const char* data, size_t size) {
+    load_count = read_binary(std::string_view(data, size), map,
+                             no_load_external);
+  });
+  return load_count;
+}
+
 } // namespace summary_serialization
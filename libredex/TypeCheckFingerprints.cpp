@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TypeCheckFingerprints.h"
+
+#include <boost/functional/hash.hpp>
+
+#include "ControlFlow.h"
+#include "DexHasher.h"
+#include "IRCode.h"
+#include "IRInstruction.h"
+#include "Resolver.h"
+#include "TypeUtil.h"
+
+size_t TypeCheckFingerprints::fingerprint(DexMethod* method) {
+  auto hash = hashing::DexMethodHasher(method).run();
+  size_t seed = hash.code_hash;
+  boost::hash_combine(seed, hash.registers_hash);
+  boost::hash_combine(seed, method->get_access());
+  add_types(seed, method->get_class(), method->get_proto());
+
+  auto* code = method->get_code();
+  if (code == nullptr) {
+    return seed;
+  }
+  if (code->cfg_built()) {
+    auto& cfg = code->cfg();
+    for (const auto& mie : cfg::InstructionIterable(cfg)) {
+      add_insn(seed, method, mie.insn);
+    }
+    for (auto* block : cfg.blocks()) {
+      for (auto* edge : block->succs()) {
+        if (edge->type() == cfg::EDGE_THROW &&
+            edge->throw_info()->catch_type != nullptr) {
+          add_type(seed, edge->throw_info()->catch_type);
+        }
+      }
+    }
+  } else {
+    for (const auto& mie : *code) {
+      if (mie.type == MFLOW_OPCODE) {
+        add_insn(seed, method, mie.insn);
+      } else if (mie.type == MFLOW_CATCH && mie.centry->catch_type != nullptr) {
+        add_type(seed, mie.centry->catch_type);
+      }
+    }
+  }
+  return seed;
+}
+
+void TypeCheckFingerprints::add_type(size_t& seed, const DexType* type) {
+  boost::hash_combine(seed, hierarchy_hash(type));
+}
+
+void TypeCheckFingerprints::add_types(size_t& seed,
+                                      const DexType* cls,
+                                      const DexProto* proto) {
+  add_type(seed, cls);
+  add_type(seed, proto->get_rtype());
+  for (auto* arg : *proto->get_args()) {
+    add_type(seed, arg);
+  }
+}
+
+void TypeCheckFingerprints::add_insn(size_t& seed,
+                                     const DexMethod* method,
+                                     const IRInstruction* insn) {
+  if (insn->has_type()) {
+    add_type(seed, insn->get_type());
+  } else if (insn->has_field()) {
+    auto* field = insn->get_field();
+    add_type(seed, field->get_class());
+    add_type(seed, field->get_type());
+    auto* def = resolve_field(field);
+    boost::hash_combine(seed, def);
+    if (def != nullptr) {
+      boost::hash_combine(seed, def->get_access());
+    }
+  } else if (insn->has_method()) {
+    auto* callee = insn->get_method();
+    add_types(seed, callee->get_class(), callee->get_proto());
+    auto* def = resolve_method(callee, opcode_to_search(insn), method);
+    boost::hash_combine(seed, def);
+    if (def != nullptr) {
+      boost::hash_combine(seed, def->get_access());
+    }
+  }
+}
+
+size_t TypeCheckFingerprints::hierarchy_hash(const DexType* type) {
+  return *m_hierarchy_hashes
+              .get_or_create_and_assert_equal(
+                  type,
+                  [this](const DexType* t) {
+                    size_t seed = std::hash<const DexType*>()(t);
+                    const auto* element_type =
+                        type::get_element_type_if_array(t);
+                    if (element_type != t) {
+                      boost::hash_combine(seed, hierarchy_hash(element_type));
+                      return seed;
+                    }
+                    const auto* cls = type_class(t);
+                    if (cls == nullptr) {
+                      return seed;
+                    }
+                    boost::hash_combine(seed, cls->get_access());
+                    if (cls->get_super_class() != nullptr) {
+                      boost::hash_combine(
+                          seed, hierarchy_hash(cls->get_super_class()));
+                    }
+                    for (auto* intf : *cls->get_interfaces()) {
+                      boost::hash_combine(seed, hierarchy_hash(intf));
+                    }
+                    return seed;
+                  })
+              .first;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "ConcurrentContainers.h"
+#include "DexClass.h"
+
+class IRInstruction;
+
+/*
+ * Summarizes everything the outcome of type checking a method depends on: its
+ * code and signature, the definitions its code resolves to, and the class
+ * hierarchy above every type involved. A method whose fingerprint did not
+ * change since it last passed the check does not need to be checked again.
+ *
+ * Fingerprints hash pointers, so they are only comparable within one run. An
+ * instance caches the hashes of the class hierarchy, so a fresh one must be
+ * used for every check.
+ */
+class TypeCheckFingerprints {
+ public:
+  // This operation is thread-safe.
+  size_t fingerprint(DexMethod* method);
+
+ private:
+  void add_type(size_t& seed, const DexType* type);
+  void add_types(size_t& seed, const DexType* cls, const DexProto* proto);
+  void add_insn(size_t& seed,
+                const DexMethod* method,
+                const IRInstruction* insn);
+
+  // Covers the type, and the access flags, super class and interfaces of it
+  // and all its ancestors.
+  size_t hierarchy_hash(const DexType* type);
+
+  InsertOnlyConcurrentMap<const DexType*, size_t> m_hierarchy_hashes;
+};
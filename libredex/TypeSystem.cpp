@@ -7,6 +7,8 @@
 
 #include "TypeSystem.h"
 
+#include <algorithm>
+
 #include "Debug.h"
 #include "RedexContext.h"
 #include "Show.h"
@@ -76,6 +78,30 @@ void load_interface_children(const Scope& scope, ClassHierarchy& children) {
 TypeSystem::TypeSystem(const Scope& scope) : m_class_scopes(scope) {
   load_interface_children(scope, m_intf_children);
   make_instanceof_interfaces_table();
+  make_implementor_intervals();
+}
+
+bool TypeSystem::implements(const DexType* cls, const DexType* intf) const {
+  const auto* interval = get_subtree_interval(cls);
+  if (interval == nullptr) {
+    // Not numbered, fall back to the interface map.
+    const auto& implementors = m_class_scopes.get_interface_map().find(intf);
+    if (implementors == m_class_scopes.get_interface_map().end()) {
+      return false;
+    }
+    return implementors->second.count(cls) > 0;
+  }
+  const auto& intervals_it = m_implementor_intervals.find(intf);
+  if (intervals_it == m_implementor_intervals.end()) {
+    return false;
+  }
+  // Find the last interval starting at or before the class.
+  const auto& intervals = intervals_it->second;
+  auto id = interval->begin;
+  auto next = std::upper_bound(
+      intervals.begin(), intervals.end(), id,
+      [](uint32_t id, const IdInterval& other) { return id < other.begin; });
+  return next != intervals.begin() && id < std::prev(next)->end;
 }
 
 void TypeSystem::get_all_super_interfaces(const DexType* intf,
@@ -196,6 +222,56 @@ void TypeSystem::make_instanceof_interfaces_table() {
   for (const auto& root : no_parents) {
     make_interfaces_table(root);
   }
+  m_preorder.reserve(m_instanceof_table.size());
+  for (const auto& root : no_parents) {
+    make_subtree_intervals(root);
+  }
+}
+
+void TypeSystem::make_subtree_intervals(const DexType* type) {
+  if (m_subtree_intervals.count(type) != 0u) {
+    return;
+  }
+  auto begin = static_cast<uint32_t>(m_preorder.size());
+  m_preorder.emplace_back(type);
+  // Reserve the entry, so that a type reachable from several roots is only
+  // numbered once.
+  m_subtree_intervals[type] = IdInterval{begin, begin + 1};
+
+  const auto& hierarchy = m_class_scopes.get_class_hierarchy();
+  const auto& children = hierarchy.find(type);
+  if (children != hierarchy.end()) {
+    for (const auto& child : children->second) {
+      make_subtree_intervals(child);
+    }
+  }
+  m_subtree_intervals[type].end = static_cast<uint32_t>(m_preorder.size());
+}
+
+void TypeSystem::make_implementor_intervals() {
+  // The implementors of an interface are closed under subclassing, hence a
+  // union of subtrees, i.e. of contiguous runs of pre-order ids.
+  std::vector<uint32_t> ids;
+  for (const auto& intf_it :
+       UnorderedIterable(m_class_scopes.get_interface_map())) {
+    ids.clear();
+    for (const auto* cls : intf_it.second) {
+      const auto* interval = get_subtree_interval(cls);
+      if (interval != nullptr) {
+        ids.push_back(interval->begin);
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    auto& intervals = m_implementor_intervals[intf_it.first];
+    for (auto id : ids) {
+      if (!intervals.empty() && intervals.back().end == id) {
+        intervals.back().end++;
+      } else {
+        intervals.push_back(IdInterval{id, id + 1});
+      }
+    }
+    intervals.shrink_to_fit();
+  }
 }
 
 void TypeSystem::make_interfaces_table(const DexType* type) {
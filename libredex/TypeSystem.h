@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <boost/range/iterator_range.hpp>
+
 #include "ClassHierarchy.h"
 #include "DeterministicContainers.h"
 #include "DexClass.h"
@@ -15,6 +17,7 @@
 using TypeVector = std::vector<const DexType*>;
 using InstanceOfTable = UnorderedMap<const DexType*, TypeVector>;
 using TypeToTypeSet = UnorderedMap<const DexType*, TypeSet>;
+using TypeRange = boost::iterator_range<TypeVector::const_iterator>;
 using namespace virt_scope;
 
 /**
@@ -28,6 +31,12 @@ using namespace virt_scope;
  * class-level and not method-level relationships, consider using ClassHierarchy
  * directly. Also, for method-level relationships, prefer the
  * MethodOverrideGraph over the VirtualScopes used here; the former is faster.
+ *
+ * Classes are numbered in depth-first pre-order of the class hierarchy, so
+ * that the subclasses of every class form a contiguous interval of ids and
+ * subtype checks are interval containment tests. The implementors of each
+ * interface, being a union of subtrees, are kept as a sorted list of such
+ * intervals.
  */
 class TypeSystem {
  private:
@@ -40,10 +49,26 @@ class TypeSystem {
     return empty_vec;
   }
 
+  // A half-open interval of pre-order ids.
+  struct IdInterval {
+    uint32_t begin;
+    uint32_t end;
+  };
+
   ClassScopes m_class_scopes;
   ClassHierarchy m_intf_children;
   InstanceOfTable m_instanceof_table;
   TypeToTypeSet m_interfaces;
+  // Classes in pre-order, and the interval of each class and its subclasses.
+  TypeVector m_preorder;
+  UnorderedMap<const DexType*, IdInterval> m_subtree_intervals;
+  UnorderedMap<const DexType*, std::vector<IdInterval>>
+      m_implementor_intervals;
+
+  const IdInterval* get_subtree_interval(const DexType* type) const {
+    auto it = m_subtree_intervals.find(type);
+    return it == m_subtree_intervals.end() ? nullptr : &it->second;
+  }
 
  public:
   explicit TypeSystem(const Scope& scope);
@@ -64,8 +89,22 @@ class TypeSystem {
    * The type must be a class (not an interface).
    */
   void get_all_children(const DexType* type, TypeSet& children) const {
-    return ::get_all_children(
-        m_class_scopes.get_class_hierarchy(), type, children);
+    const auto range = get_all_children(type);
+    children.insert(range.begin(), range.end());
+  }
+
+  /**
+   * Get all the children of a given type, in depth-first pre-order, without
+   * copying them.
+   * The type must be a class (not an interface).
+   */
+  TypeRange get_all_children(const DexType* type) const {
+    const auto* interval = get_subtree_interval(type);
+    if (interval == nullptr) {
+      return TypeRange(m_preorder.end(), m_preorder.end());
+    }
+    return TypeRange(m_preorder.begin() + interval->begin + 1,
+                     m_preorder.begin() + interval->end);
   }
 
   /**
@@ -114,18 +153,13 @@ class TypeSystem {
    * The type must be a class (not an interface).
    */
   bool is_subtype(const DexType* parent, const DexType* child) const {
-    const auto& parent_it = m_instanceof_table.find(parent);
-    const auto& child_it = m_instanceof_table.find(child);
-    if (parent_it == m_instanceof_table.end() ||
-        child_it == m_instanceof_table.end()) {
+    const auto* parent_interval = get_subtree_interval(parent);
+    const auto* child_interval = get_subtree_interval(child);
+    if (parent_interval == nullptr || child_interval == nullptr) {
       return false;
     }
-    const auto& p_chain = parent_it->second;
-    const auto& c_chain = child_it->second;
-    if (p_chain.size() > c_chain.size()) {
-      return false;
-    }
-    return c_chain.at(p_chain.size() - 1) == parent;
+    return parent_interval->begin <= child_interval->begin &&
+           child_interval->begin < parent_interval->end;
   }
 
   /**
@@ -133,13 +167,7 @@ class TypeSystem {
    * The interface may be implemented via some parent of the class
    * or an interface DAG.
    */
-  bool implements(const DexType* cls, const DexType* intf) const {
-    const auto& implementors = m_class_scopes.get_interface_map().find(intf);
-    if (implementors == m_class_scopes.get_interface_map().end()) {
-      return false;
-    }
-    return implementors->second.count(cls) > 0;
-  }
+  bool implements(const DexType* cls, const DexType* intf) const;
 
   /**
    * Return all classes that implement an interface.
@@ -237,4 +265,6 @@ class TypeSystem {
  private:
   void make_instanceof_interfaces_table();
   void make_interfaces_table(const DexType* type);
+  void make_subtree_intervals(const DexType* type);
+  void make_implementor_intervals();
 };
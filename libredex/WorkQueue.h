@@ -12,6 +12,7 @@
 
 #include <sparta/WorkQueue.h>
 
+#include "ChromeTraceWriter.h"
 #include "DeterministicContainers.h"
 #include "ThreadPool.h"
 
@@ -19,13 +20,32 @@ namespace redex_workqueue_impl {
 
 void redex_queue_exception_handler(std::exception& e);
 
+// Runs a single work item. Items that take at least the configured chrome
+// trace work item threshold are recorded as their own trace events, which
+// makes stragglers of parallel walks visible.
+template <typename Fn>
+void run_work_item(const Fn& fn) {
+  auto threshold = ChromeTraceWriter::work_item_threshold();
+  if (threshold.count() == 0) {
+    fn();
+    return;
+  }
+  auto start = ChromeTraceWriter::clock::now();
+  fn();
+  auto end = ChromeTraceWriter::clock::now();
+  if (end - start >= threshold) {
+    ChromeTraceWriter::record("work item", start, end,
+                              std::this_thread::get_id());
+  }
+}
+
 // Helper classes so the type of Executor can be inferred
 template <typename Input, typename Fn>
 struct NoStateWorkQueueHelper {
   Fn fn;
   void operator()(sparta::WorkerState<Input>*, Input a) {
     try {
-      fn(std::move(a));
+      run_work_item([&]() { fn(std::move(a)); });
     } catch (std::exception& e) {
       redex_queue_exception_handler(e);
       throw;
@@ -38,7 +58,7 @@ struct WithStateWorkQueueHelper {
   Fn fn;
   void operator()(sparta::WorkerState<Input>* state, Input a) {
     try {
-      fn(state, std::move(a));
+      run_work_item([&]() { fn(state, std::move(a)); });
     } catch (std::exception& e) {
       redex_queue_exception_handler(e);
       throw;
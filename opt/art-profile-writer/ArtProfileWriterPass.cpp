@@ -28,6 +28,7 @@
 #include "IRCode.h"
 #include "InstructionLowering.h"
 #include "LoopInfo.h"
+#include "MethodFacts.h"
 #include "MethodProfiles.h"
 #include "PassManager.h"
 #include "Show.h"
@@ -185,21 +186,8 @@ void never_inline(bool attach_annotations,
   std::atomic<size_t> callers_too_many_registers{0};
   InsertOnlyConcurrentSet<DexMethod*> hot_cold_callees;
   InsertOnlyConcurrentSet<DexMethod*> hot_hot_callees;
-  InsertOnlyConcurrentMap<DexMethod*, uint32_t> estimated_code_units;
-  InsertOnlyConcurrentMap<DexMethod*, size_t> estimated_instructions;
-  InsertOnlyConcurrentMap<DexMethod*, bool> has_catches;
+  const auto& method_facts = mgr.get_method_facts(scope);
   walk::parallel::code(scope, [&](DexMethod* method, IRCode& code) {
-    uint32_t ecu = code.estimate_code_units();
-    estimated_code_units.emplace(method, ecu);
-    size_t instructions = code.count_opcodes();
-    estimated_instructions.emplace(method, instructions);
-
-    auto blocks = code.cfg().blocks();
-    bool has_catch =
-        std::any_of(blocks.begin(), blocks.end(),
-                    [](cfg::Block* block) { return block->is_catch(); });
-    has_catches.emplace(method, has_catch);
-
     type_inference::TypeInference ti(code.cfg());
     ti.run(method);
     const auto& type_envs = ti.get_type_environments();
@@ -248,7 +236,7 @@ void never_inline(bool attach_annotations,
     if (!is_compiled(baseline_profile, caller)) {
       return;
     }
-    size_t caller_instructions = estimated_instructions.at(caller);
+    size_t caller_instructions = method_facts.get(caller).instructions;
     // Over the 1024 threshold of the AOT compiler, to be conservative.
     size_t MAX_INSTRUCTIONS = 1100;
     if (caller_instructions > MAX_INSTRUCTIONS) {
@@ -289,12 +277,12 @@ void never_inline(bool attach_annotations,
           continue;
         }
 
-        auto it = estimated_instructions.find(callee);
-        if (it == estimated_instructions.end()) {
+        // Only callees with code in the scope were analyzed above.
+        if (receiver_types.count(callee) == 0) {
           continue;
         }
 
-        if (callsite_has_catch && has_catches.at(callee)) {
+        if (callsite_has_catch && method_facts.get(callee).has_catches) {
           continue;
         }
 
@@ -341,14 +329,15 @@ void never_inline(bool attach_annotations,
       return;
     }
 
-    auto ecu = estimated_code_units.at(method);
+    const auto& facts = method_facts.get(method);
+    auto ecu = facts.code_units;
     if (ecu > 40) {
       // Way over the 14 threshold of the AOT compiler, to be conservative.
       callees_too_large.fetch_add(1);
       return;
     }
 
-    auto instructions = estimated_instructions.at(method);
+    auto instructions = facts.instructions;
     if (instructions <= 3) {
       callees_too_small.fetch_add(1);
       return;
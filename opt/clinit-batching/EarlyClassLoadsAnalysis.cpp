@@ -710,7 +710,7 @@ void EarlyClassLoadsAnalysis::walk_callgraph(
             "dominance analysis",
             SHOW(method));
 
-      auto doms = dominators::SimpleFastDominators<cfg::GraphInterface>(cfg);
+      const auto& doms = cfg.get_dominators();
 
       // Pre-compute the set of blocks strictly dominated by the
       // orchestrator's block. A block B is strictly dominated by
@@ -924,7 +924,8 @@ InstrumentPass::patch_sharded_arrays(
               suggested_names.count(static_cast<int>(i)) != 0u
                   ? suggested_names.at(static_cast<int>(i))
                   : InstrumentPass::STATS_FIELD_NAME + std::to_string(i);
-          auto deobfuscated_name = template_field->get_deobfuscated_name();
+          auto deobfuscated_name =
+              template_field->get_deobfuscated_name_or_empty_copy();
           boost::replace_first(deobfuscated_name,
                                InstrumentPass::STATS_FIELD_NAME, new_name);
 
@@ -259,6 +259,10 @@ void InterDexPass::run_pass(
   mgr.set_metric(METRIC_REORDER_RESETS, cross_dex_ref_minimizer_stats.resets);
   mgr.set_metric(METRIC_REORDER_REPRIORITIZATIONS,
                  cross_dex_ref_minimizer_stats.reprioritizations);
+  mgr.set_metric(METRIC_REORDER_INVALIDATIONS,
+                 cross_dex_ref_minimizer_stats.invalidations);
+  mgr.set_metric(METRIC_REORDER_MAX_INVALIDATIONS,
+                 cross_dex_ref_minimizer_stats.max_invalidations);
   const auto& seed_classes = cross_dex_ref_minimizer_stats.seed_classes;
   for (size_t i = 0; i < seed_classes.size(); ++i) {
     const auto& p = seed_classes.at(i);
@@ -16,6 +16,10 @@ constexpr const char* METRIC_REORDER_CLASSES = "num_reorder_classes";
 constexpr const char* METRIC_REORDER_RESETS = "num_reorder_resets";
 constexpr const char* METRIC_REORDER_REPRIORITIZATIONS =
     "num_reorder_reprioritization";
+constexpr const char* METRIC_REORDER_INVALIDATIONS =
+    "num_reorder_invalidations";
+constexpr const char* METRIC_REORDER_MAX_INVALIDATIONS =
+    "max_reorder_invalidations";
 constexpr const char* METRIC_REORDER_CLASSES_SEEDS = "reorder_classes_seeds";
 
 constexpr const char* METRIC_CLASSES_ADDED_FOR_RELOCATED_METHODS =
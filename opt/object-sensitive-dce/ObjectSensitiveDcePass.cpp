@@ -7,8 +7,6 @@
 
 #include "ObjectSensitiveDcePass.h"
 
-#include <fstream>
-
 #include "ConfigFiles.h"
 #include "Debug.h"
 #include "DexUtil.h"
@@ -43,15 +41,15 @@ void ObjectSensitiveDcePass::run_pass(DexStoresVector& stores,
 
   ptrs::SummaryMap escape_summaries;
   if (m_external_escape_summaries_file) {
-    std::ifstream file_input(*m_external_escape_summaries_file);
-    summary_serialization::read(file_input, &escape_summaries);
+    summary_serialization::read_file(*m_external_escape_summaries_file,
+                                     &escape_summaries);
   }
   mgr.incr_metric("external_escape_summaries", escape_summaries.size());
 
   side_effects::SummaryMap effect_summaries;
   if (m_external_side_effect_summaries_file) {
-    std::ifstream file_input(*m_external_side_effect_summaries_file);
-    summary_serialization::read(file_input, &effect_summaries);
+    summary_serialization::read_file(*m_external_side_effect_summaries_file,
+                                     &effect_summaries);
   }
   mgr.incr_metric("external_side_effect_summaries", effect_summaries.size());
 
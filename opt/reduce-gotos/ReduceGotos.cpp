@@ -503,7 +503,7 @@ std::tuple<bool, size_t, size_t> process_code_ifs_impl(
     if (n_slots > 0 && !b->preds().empty()) {
       source_blocks::apportion::shrink_by_departed(b, leaving_share);
     } else if (!insns_to_add.empty() && !b->preds().empty()) {
-      auto doms = dominators::SimpleFastDominators<cfg::GraphInterface>(cfg);
+      const auto& doms = cfg.get_dominators();
       auto* idom = doms.get_idom(b);
       if (idom != nullptr) {
         auto* idom_sb = source_blocks::get_last_source_block(idom);
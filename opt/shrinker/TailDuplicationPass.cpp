@@ -327,6 +327,8 @@ void TailDuplicationPass::run_pass(DexStoresVector& stores,
   mgr.incr_metric("instructions_eliminated_branch_prefix_hoisting",
                   shrinker.get_branch_prefix_hoisting_stats());
   mgr.incr_metric("methods_reg_alloced", shrinker.get_methods_reg_alloced());
+  mgr.incr_metric("shared_type_inferences",
+                  shrinker.get_shared_type_inferences());
   mgr.incr_metric("localdce_init_class_instructions_added",
                   shrinker.get_local_dce_stats().init_class_instructions_added);
   mgr.incr_metric(
@@ -700,6 +700,29 @@ size_t process_code(IRCode* code, DexMethod* method, bool can_allocate_regs) {
   return ret;
 }
 
+size_t process_cfg(
+    cfg::ControlFlowGraph& cfg,
+    bool is_static,
+    DexType* declaring_type,
+    DexProto* proto,
+    const std::function<std::string()>& method_describer,
+    std::unique_ptr<type_inference::TypeInference> type_inference,
+    bool can_allocate_regs) {
+  bool eager = type_inference != nullptr;
+  Lazy<const constant_uses::ConstantUses> constant_uses([&] {
+    return std::make_unique<const constant_uses::ConstantUses>(
+        cfg, is_static, declaring_type, proto->get_rtype(), proto->get_args(),
+        method_describer,
+        /* force_type_inference */ true, std::move(type_inference));
+  });
+  if (eager) {
+    // The given type inference only describes the cfg until the first
+    // hoisting changes it, so it must be taken up before that.
+    (void)*constant_uses;
+  }
+  return process_cfg(cfg, constant_uses, can_allocate_regs);
+}
+
 size_t process_cfg(cfg::ControlFlowGraph& cfg,
                    Lazy<const constant_uses::ConstantUses>& constant_uses,
                    bool can_allocate_regs) {
@@ -22,4 +22,13 @@ size_t process_code(IRCode*, DexMethod*, bool can_allocate_regs = true);
 size_t process_cfg(cfg::ControlFlowGraph&,
                    Lazy<const constant_uses::ConstantUses>&,
                    bool can_allocate_regs = true);
+// A type inference of the cfg as it is now may be given to be used instead of
+// running a new one.
+size_t process_cfg(cfg::ControlFlowGraph&,
+                   bool is_static,
+                   DexType* declaring_type,
+                   DexProto* proto,
+                   const std::function<std::string()>& method_describer,
+                   std::unique_ptr<type_inference::TypeInference>,
+                   bool can_allocate_regs = true);
 } // namespace branch_prefix_hoisting_impl
@@ -8,6 +8,7 @@
 #include "MergeabilityCheck.h"
 
 #include "ClassUtil.h"
+#include "ConcurrentContainers.h"
 #include "DexUtil.h"
 #include "IRCode.h"
 #include "LiveRange.h"
@@ -18,6 +19,7 @@
 #include "Show.h"
 #include "Trace.h"
 #include "Walkers.h"
+#include "WorkQueue.h"
 
 using namespace class_merging;
 
@@ -309,18 +311,26 @@ void MergeabilityChecker::exclude_static_fields(TypeSet& non_mergeables) {
 void MergeabilityChecker::exclude_unsafe_sdk_and_store_refs(
     TypeSet& non_mergeables) {
   const auto mog = method_override_graph::build_graph(m_scope);
+  std::vector<const DexType*> candidates;
   for (const auto* type : UnorderedIterable(m_spec.merging_targets)) {
-    if (non_mergeables.count(type) != 0u) {
-      continue;
-    }
-    auto* cls = type_class(type);
-    if (!m_ref_checker.check_class(cls, mog)) {
-      non_mergeables.insert(type);
-    }
-    if (!m_spec.include_primary_dex && m_ref_checker.is_in_primary_dex(type)) {
-      non_mergeables.insert(type);
+    if (non_mergeables.count(type) == 0u) {
+      candidates.push_back(type);
     }
   }
+  // Checking a class walks all of its code, and the RefChecker caches are
+  // concurrent, so check the candidates in parallel.
+  ConcurrentSet<const DexType*> unsafe_types;
+  workqueue_run<const DexType*>(
+      [&](const DexType* type) {
+        auto* cls = type_class(type);
+        if (!m_ref_checker.check_class(cls, mog) ||
+            (!m_spec.include_primary_dex &&
+             m_ref_checker.is_in_primary_dex(type))) {
+          unsafe_types.insert(type);
+        }
+      },
+      candidates);
+  insert_unordered_iterable(non_mergeables, unsafe_types);
 }
 
 // Helper to recursively extract all types referenced by an encoded value
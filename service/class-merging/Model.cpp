@@ -1338,7 +1338,7 @@ Model Model::build_model(const Scope& scope,
                          const TypeSystem& type_system,
                          const virtual_scope::VirtualScopes& vscopes,
                          const RefChecker& refchecker) {
-  Timer t("build_model");
+  Timer t("build_model " + spec.name);
 
   TRACE(CLMG, 3, "Build Model for %s", to_string(spec).c_str());
   Model model(scope, stores, conf, spec, type_system, vscopes, refchecker);
@@ -100,38 +100,54 @@ void CrossDexRefMinimizer::ClassDiffSet::compact() {
   m_diff.clear();
 }
 
-void CrossDexRefMinimizer::reprioritize(
-    const UnorderedMap<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>&
-        affected_classes) {
+CrossDexRefMinimizer::ClassInfo& CrossDexRefMinimizer::invalidate(
+    DexClass* cls) {
+  auto& class_info = m_class_infos.at(cls);
+  if (!class_info.stale) {
+    class_info.stale = true;
+    m_stale_classes.push_back(cls);
+  }
+  return class_info;
+}
+
+void CrossDexRefMinimizer::record_invalidations(uint64_t invalidations) {
+  m_stats.invalidations += invalidations;
+  m_stats.max_invalidations =
+      std::max(m_stats.max_invalidations, invalidations);
+}
+
+void CrossDexRefMinimizer::reprioritize() {
+  if (m_stale_classes.empty()) {
+    return;
+  }
   TRACE(IDEX, 4, "[dex ordering] Reprioritizing %zu classes",
-        affected_classes.size());
-  for (auto p : UnorderedIterable(affected_classes)) {
-    ++m_stats.reprioritizations;
-    DexClass* affected_class = p.first;
-    CrossDexRefMinimizer::ClassInfoDelta& delta = p.second;
-    CrossDexRefMinimizer::ClassInfo& affected_class_info =
-        m_class_infos.at(affected_class);
-    affected_class_info.applied_refs_weight += delta.applied_refs_weight;
-    for (size_t i = 0; i < INFREQUENT_REFS_COUNT; ++i) {
-      affected_class_info.infrequent_refs_weight[i] +=
-          delta.infrequent_refs_weight[i];
+        m_stale_classes.size());
+  for (auto* cls : m_stale_classes) {
+    auto it = m_class_infos.find(cls);
+    if (it == m_class_infos.end() || !it->second.stale) {
+      // The class was erased since it was invalidated.
+      continue;
     }
-
-    const auto priority = affected_class_info.get_priority();
-    m_prioritized_classes.update_priority(affected_class, priority);
-    TRACE(
-        IDEX, 5,
-        "[dex ordering] Reprioritized class {%s} with priority %016" PRIu64
-        "; index %u; %" PRIu64 " (delta %" PRId64
-        ") applied refs weight, %s (delta %s) infrequent refs weights, %zu "
-        "total refs",
-        SHOW(affected_class), priority, affected_class_info.index,
-        affected_class_info.applied_refs_weight, delta.applied_refs_weight,
-        format_infrequent_refs_array(affected_class_info.infrequent_refs_weight)
-            .c_str(),
-        format_infrequent_refs_array(delta.infrequent_refs_weight).c_str(),
-        affected_class_info.refs->size());
+    auto& class_info = it->second;
+    class_info.stale = false;
+    const auto priority = class_info.get_priority();
+    if (class_info.queued) {
+      ++m_stats.reprioritizations;
+      m_prioritized_classes.update_priority(cls, priority);
+    } else {
+      class_info.queued = true;
+      m_prioritized_classes.insert(cls, priority);
+    }
+    TRACE(IDEX, 5,
+          "[dex ordering] Reprioritized class {%s} with priority %016" PRIu64
+          "; index %u; %" PRIu64
+          " applied refs weight, %s infrequent refs weights, %zu total refs",
+          SHOW(cls), priority, class_info.index, class_info.applied_refs_weight,
+          format_infrequent_refs_array(class_info.infrequent_refs_weight)
+              .c_str(),
+          class_info.refs->size());
   }
+  m_stale_classes.clear();
 }
 
 void CrossDexRefMinimizer::sample(DexClass* cls) {
@@ -244,65 +260,60 @@ void CrossDexRefMinimizer::insert(DexClass* cls) {
     add_weight(fref, m_config.field_ref_weight, m_config.field_seed_weight);
   }
 
-  UnorderedMap<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>
-      affected_classes;
+  uint64_t invalidations{0};
   for (const auto& p : refs) {
     const auto* ref = p.first;
     uint32_t weight = p.second;
     auto& classes = m_ref_classes[ref];
     size_t frequency = classes.size();
-    // We record the need to undo (subtract weight of) a previously claimed
-    // infrequent ref. The actual undoing happens later in
-    // reprioritize.
-    if (frequency > 0 && frequency <= INFREQUENT_REFS_COUNT) {
+    // The ref moves from the infrequency bucket for `frequency` classes to the
+    // one for `frequency + 1` classes, for all classes that already have it.
+    // Their priorities get recomputed in the next reprioritize.
+    if (frequency > 0 && frequency < INFREQUENT_REFS_COUNT) {
+      for (DexClass* affected_class : classes) {
+        always_assert(affected_class != cls);
+        auto& weights = invalidate(affected_class).infrequent_refs_weight;
+        weights[frequency - 1] -= weight;
+        weights[frequency] += weight;
+        ++invalidations;
+      }
+    } else if (frequency == INFREQUENT_REFS_COUNT) {
       for (DexClass* affected_class : classes) {
         always_assert(affected_class != cls);
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] -=
-            static_cast<int32_t>(weight);
+        invalidate(affected_class).infrequent_refs_weight[frequency - 1] -=
+            weight;
+        ++invalidations;
       }
     }
     ++frequency;
-    // We are recording a new infrequent unapplied ref, if any.
-    // This happens immediately for the to be inserted class cls,
-    // so that it can be used right away by the upcoming
-    // class_info.get_priority() call, while all other change requests happen
-    // later in reprioritize.
+    // We are recording a new infrequent unapplied ref, if any, for the to be
+    // inserted class cls.
     if (frequency <= INFREQUENT_REFS_COUNT) {
-      for (DexClass* affected_class : classes) {
-        affected_classes[affected_class]
-            .infrequent_refs_weight[frequency - 1] +=
-            static_cast<int32_t>(weight);
-      }
-      class_info.infrequent_refs_weight[frequency - 1] +=
-          static_cast<int32_t>(weight);
+      class_info.infrequent_refs_weight[frequency - 1] += weight;
     }
 
-    // There's an implicit invariant that class_info and the keys of
-    // affected_classes are disjoint, so we are not going to reprioritize
-    // the class that we are adding here.
     classes.insert(cls);
   }
-  const auto priority = class_info.get_priority();
-  m_prioritized_classes.insert(cls, priority);
+  record_invalidations(invalidations);
+  // The class enters the priority queue in the next reprioritize, as its
+  // priority may still change as other classes get inserted.
+  invalidate(cls);
   TRACE(IDEX, 4,
         "[dex ordering] Inserting class {%s} with priority %016" PRIu64
         "; index %u; %s infrequent refs weights, %zu total refs",
-        SHOW(cls), priority, class_info.index,
+        SHOW(cls), class_info.get_priority(), class_info.index,
         format_infrequent_refs_array(class_info.infrequent_refs_weight).c_str(),
         refs.size());
   if (m_json_classes) {
     (*m_json_classes)[get_json_class_index(cls)]["insert_index"] =
         class_info.index;
   }
-  reprioritize(affected_classes);
 }
 
-bool CrossDexRefMinimizer::empty() const {
-  return m_prioritized_classes.empty();
-}
+bool CrossDexRefMinimizer::empty() const { return m_class_infos.empty(); }
 
-DexClass* CrossDexRefMinimizer::front() const {
+DexClass* CrossDexRefMinimizer::front() {
+  reprioritize();
   return m_prioritized_classes.front();
 }
 
@@ -381,7 +392,6 @@ DexClass* CrossDexRefMinimizer::worst() {
 size_t CrossDexRefMinimizer::erase(DexClass* cls, bool emitted, bool reset) {
   auto class_info_it = m_class_infos.end();
   if (cls != nullptr) {
-    m_prioritized_classes.erase(cls);
     class_info_it = m_class_infos.find(cls);
     always_assert(class_info_it != m_class_infos.end());
     const auto& class_info = class_info_it->second;
@@ -403,17 +413,27 @@ size_t CrossDexRefMinimizer::erase(DexClass* cls, bool emitted, bool reset) {
   }
 
   // Updating m_applied_refs and m_ref_classes,
-  // and gathering information on how this affects other classes
+  // and applying how this affects other classes
 
   if (reset) {
     TRACE(IDEX, 3, "[dex ordering] Reset");
     ++m_stats.resets;
     m_applied_refs.clear();
+    // All classes get re-inserted into the priority queue in the next
+    // reprioritize.
+    m_prioritized_classes.clear();
+    m_stale_classes.clear();
+    for (auto& [reset_class, reset_class_info] :
+         UnorderedIterable(m_class_infos)) {
+      reset_class_info.applied_refs_weight = 0;
+      reset_class_info.queued = false;
+      reset_class_info.stale = true;
+      m_stale_classes.push_back(reset_class);
+    }
   }
 
-  UnorderedMap<DexClass*, CrossDexRefMinimizer::ClassInfoDelta>
-      affected_classes;
   size_t old_applied_refs = m_applied_refs.size();
+  uint64_t invalidations{0};
   if (class_info_it != m_class_infos.end()) {
     const auto& class_info = class_info_it->second;
     const auto& refs = *class_info.refs;
@@ -426,59 +446,52 @@ size_t CrossDexRefMinimizer::erase(DexClass* cls, bool emitted, bool reset) {
       size_t frequency = classes.size();
       always_assert(frequency > 0);
       classes.erase(cls);
-      if (frequency <= INFREQUENT_REFS_COUNT) {
-        for (DexClass* affected_class : classes) {
-          affected_classes[affected_class]
-              .infrequent_refs_weight[frequency - 1] -=
-              static_cast<int32_t>(weight);
-        }
-      }
       --frequency;
       if (frequency == 0) {
         m_ref_classes.erase(classes_it);
-      } else if (frequency <= INFREQUENT_REFS_COUNT) {
-        for (DexClass* affected_class : classes) {
-          affected_classes[affected_class]
-              .infrequent_refs_weight[frequency - 1] +=
-              static_cast<int32_t>(weight);
+        if (emitted) {
+          m_applied_refs.insert(ref);
         }
-      }
-
-      if (!emitted) {
-        continue;
-      }
-      if (!m_applied_refs.insert(ref).second) {
         continue;
       }
-      if (frequency == 0) {
+
+      // The ref moves from the infrequency bucket for `frequency + 1` classes
+      // to the one for `frequency` classes, for all remaining classes that
+      // have it, and may become applied for them.
+      bool newly_applied = emitted && m_applied_refs.insert(ref).second;
+      if (frequency > INFREQUENT_REFS_COUNT && !newly_applied) {
         continue;
       }
       for (DexClass* affected_class : classes) {
-        affected_classes[affected_class].applied_refs_weight += weight;
+        auto& affected_class_info = invalidate(affected_class);
+        auto& weights = affected_class_info.infrequent_refs_weight;
+        if (frequency < INFREQUENT_REFS_COUNT) {
+          weights[frequency] -= weight;
+        }
+        if (frequency <= INFREQUENT_REFS_COUNT) {
+          weights[frequency - 1] += weight;
+        }
+        if (newly_applied) {
+          affected_class_info.applied_refs_weight += weight;
+        }
+        ++invalidations;
       }
     }
 
     // Updating m_class_infos and m_prioritized_classes
 
+    if (class_info_it->second.queued) {
+      m_prioritized_classes.erase(cls);
+    }
     m_class_infos.erase(class_info_it);
   }
+  record_invalidations(invalidations);
 
-  if (reset) {
-    m_prioritized_classes.clear();
-    for (auto& [reset_class, reset_class_info] :
-         UnorderedIterable(m_class_infos)) {
-      reset_class_info.applied_refs_weight = 0;
-      const auto priority = reset_class_info.get_priority();
-      m_prioritized_classes.insert(reset_class, priority);
-      always_assert(reset_class_info.applied_refs_weight == 0);
-    }
-  }
   if (emitted) {
     TRACE(IDEX, 4, "[dex ordering] %zu + %zu = %zu applied refs",
           old_applied_refs, m_applied_refs.size() - old_applied_refs,
           m_applied_refs.size());
   }
-  reprioritize(affected_classes);
   return m_applied_refs.size() - old_applied_refs;
 }
 
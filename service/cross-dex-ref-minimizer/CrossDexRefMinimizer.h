@@ -33,7 +33,13 @@ using PrioritizedDexClasses = MutablePriorityQueue<DexClass*, uint64_t>;
 struct CrossDexRefMinimizerStats {
   uint64_t classes{0};
   uint64_t resets{0};
+  // Number of priority updates actually applied to the priority queue.
   uint64_t reprioritizations{0};
+  // Number of weight updates applied to other classes sharing refs with an
+  // inserted or erased class, and the largest such number for a single
+  // insertion or erasure.
+  uint64_t invalidations{0};
+  uint64_t max_invalidations{0};
   std::vector<std::pair<DexClass*, uint64_t>> seed_classes;
 };
 
@@ -67,6 +73,12 @@ struct CrossDexRefMinimizerConfig {
 // - If there is a tie, use the original ordering as a tie breaker
 // TODO: Try some other variations.
 //
+// Inserting or erasing a class updates the weights of all classes that share
+// refs with it, found via the inverted index m_ref_classes. Their priorities
+// are only invalidated then; the priority queue is updated in one batch when
+// the next class is selected, so that a class affected by many consecutive
+// insertions is reprioritized only once.
+//
 // (All this isn't entirely accurate, as it doesn't account for the dynamic
 // behavior of plugins.)
 //
@@ -97,6 +109,10 @@ class CrossDexRefMinimizer {
     uint64_t refs_weight;
     uint64_t applied_refs_weight;
     uint64_t seed_weight{0};
+    // Whether the class is in m_prioritized_classes, and whether its priority
+    // there is out of date.
+    bool queued{false};
+    bool stale{false};
     explicit ClassInfo(uint32_t i)
         : index(i),
           infrequent_refs_weight(),
@@ -185,13 +201,14 @@ class CrossDexRefMinimizer {
   CrossDexRefMinimizerConfig m_config;
   ClassReferencesCache* m_cache;
 
-  struct ClassInfoDelta {
-    std::array<int32_t, INFREQUENT_REFS_COUNT> infrequent_refs_weight{};
-    int64_t applied_refs_weight{0};
-  };
+  // Classes whose priority may be out of date, in invalidation order.
+  std::vector<DexClass*> m_stale_classes;
+
+  ClassInfo& invalidate(DexClass* cls);
+
+  void record_invalidations(uint64_t invalidations);
 
-  void reprioritize(
-      const UnorderedMap<DexClass*, ClassInfoDelta>& affected_classes);
+  void reprioritize();
 
   UnorderedMap<const void*, size_t> m_ref_counts;
   size_t m_max_ref_count{0};
@@ -268,7 +285,7 @@ class CrossDexRefMinimizer {
   void sample(DexClass* cls);
   void insert(DexClass* cls);
   bool empty() const;
-  DexClass* front() const;
+  DexClass* front();
   // "Worst" in the sense of having highest seed weight.
   DexClass* worst();
   std::vector<DexClass*> worst(size_t, bool include_generated = true);
@@ -90,7 +90,9 @@ ConstantUses::ConstantUses(const cfg::ControlFlowGraph& cfg,
                            DexType* rtype,
                            DexTypeList* args,
                            const std::function<std::string()>& method_describer,
-                           bool force_type_inference)
+                           bool force_type_inference,
+                           std::unique_ptr<type_inference::TypeInference>
+                               type_inference)
     : m_rtype(rtype) {
   static AccumulatingTimer s_timer("ConstantUses::ConstantUses");
   auto t = s_timer.scope();
@@ -147,8 +149,12 @@ ConstantUses::ConstantUses(const cfg::ControlFlowGraph& cfg,
   TRACE(CU, 2, "[CU] ConstantUses(%s) need_type_inference:%d",
         method_describer().c_str(), need_type_inference);
   if ((need_type_inference && (args != nullptr)) || force_type_inference) {
-    m_type_inference.reset(new type_inference::TypeInference(cfg));
-    m_type_inference->run(is_static, declaring_type, args);
+    if (type_inference) {
+      m_type_inference = std::move(type_inference);
+    } else {
+      m_type_inference.reset(new type_inference::TypeInference(cfg));
+      m_type_inference->run(is_static, declaring_type, args);
+    }
   }
 }
 
@@ -31,13 +31,17 @@ class ConstantUses {
   ConstantUses(const cfg::ControlFlowGraph& cfg,
                DexMethod* method,
                bool force_type_inference = false);
+  // A type inference of the cfg, run with the same parameters, may be given
+  // to be used instead of running a new one when needed.
   ConstantUses(const cfg::ControlFlowGraph& cfg,
                bool is_static,
                DexType* declaring_type,
                DexType* rtype,
                DexTypeList* args,
                const std::function<std::string()>& method_describer,
-               bool force_type_inference = false);
+               bool force_type_inference = false,
+               std::unique_ptr<type_inference::TypeInference> type_inference =
+                   nullptr);
 
   // Given a const or const-wide instruction, retrieve all instructions that
   // use it.
@@ -417,18 +417,30 @@ class DedupBlocksImpl {
     always_assert(m_config);
   }
 
-  // Dedup blocks that are exactly the same
+  // Dedup blocks that are exactly the same. If nothing was deduplicated and
+  // a type inference had to be computed, it is valid for the resulting cfg and
+  // stored in `type_inference`.
   bool dedup(bool is_static,
              DexType* declaring_type,
              DexTypeList* args,
-             cfg::ControlFlowGraph& cfg) {
+             cfg::ControlFlowGraph& cfg,
+             std::unique_ptr<type_inference::TypeInference>* type_inference) {
+    type_inference->reset();
     cfg.calculate_exit_block();
     LivenessFixpointIterator liveness_fixpoint_iter(cfg);
     liveness_fixpoint_iter.run({});
     DedupBlkValueNumbering::BlockValues block_values(liveness_fixpoint_iter);
-    Duplicates dups = collect_duplicates(is_static, declaring_type, args, cfg,
-                                         block_values, liveness_fixpoint_iter);
-    if (!dups.empty()) {
+    Lazy<type_inference::TypeInference> lazy_type_inference([&]() {
+      auto res = std::make_unique<type_inference::TypeInference>(cfg);
+      res->run(is_static, declaring_type, args);
+      return res;
+    });
+    Duplicates dups = collect_duplicates(cfg, block_values,
+                                         liveness_fixpoint_iter,
+                                         lazy_type_inference);
+    if (dups.empty()) {
+      *type_inference = lazy_type_inference.release();
+    } else {
       if (m_config->debug) {
         check_inits(cfg);
       }
@@ -500,12 +512,10 @@ class DedupBlocksImpl {
 
   // Find blocks with the same exact code
   Duplicates collect_duplicates(
-      bool is_static,
-      DexType* declaring_type,
-      DexTypeList* args,
       cfg::ControlFlowGraph& cfg,
       DedupBlkValueNumbering::BlockValues& block_values,
-      LivenessFixpointIterator& liveness_fixpoint_iter) {
+      LivenessFixpointIterator& liveness_fixpoint_iter,
+      Lazy<type_inference::TypeInference>& type_inference) {
     const auto& blocks = cfg.blocks();
     Duplicates duplicates;
 
@@ -530,11 +540,6 @@ class DedupBlocksImpl {
       }
     }
 
-    Lazy<type_inference::TypeInference> type_inference([&]() {
-      auto res = std::make_unique<type_inference::TypeInference>(cfg);
-      res->run(is_static, declaring_type, args);
-      return res;
-    });
     remove_if(duplicates, [&](auto& blocks) {
       return is_singleton_or_inconsistent(
           blocks, live_ranges, liveness_fixpoint_iter, type_inference);
@@ -1527,7 +1532,8 @@ void DedupBlocks::run() {
     if (m_config->split_postfix) {
       impl.split_postfix(cfg);
     }
-  } while (impl.dedup(m_is_static, m_declaring_type, m_args, cfg) &&
+  } while (impl.dedup(m_is_static, m_declaring_type, m_args, cfg,
+                      &m_type_inference) &&
            iteration < m_config->max_iteration);
 }
 
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <memory>
+
 #include "DeterministicContainers.h"
 #include "DexClass.h"
+#include "TypeInference.h"
 
 class IRInstruction;
 
@@ -51,6 +54,13 @@ class DedupBlocks {
 
   void run();
 
+  // The type inference of the cfg as left by run(), if one was computed
+  // anyway and the last round did not change the cfg. Callers which go on to
+  // analyze the same cfg can use it instead of running their own.
+  std::unique_ptr<type_inference::TypeInference> release_type_inference() {
+    return std::move(m_type_inference);
+  }
+
  private:
   const Config* m_config;
   IRCode* m_code;
@@ -58,6 +68,7 @@ class DedupBlocks {
   DexType* m_declaring_type;
   DexTypeList* m_args;
   Stats m_stats;
+  std::unique_ptr<type_inference::TypeInference> m_type_inference;
 };
 
 } // namespace dedup_blocks_impl
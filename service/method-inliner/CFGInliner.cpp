@@ -361,6 +361,9 @@ void CFGInliner::steal_contents(ControlFlowGraph* caller,
   caller->m_edges.reserve(caller->m_edges.size() + callee->m_edges.size());
   insert_unordered_iterable(caller->m_edges, callee->m_edges);
   callee->m_edges.clear();
+
+  caller->bump_structure_version();
+  callee->bump_structure_version();
 }
 
 /*
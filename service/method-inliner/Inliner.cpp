@@ -328,6 +328,9 @@ void MultiMethodInliner::inline_methods() {
   if (m_ref_checkers) {
     m_callee_code_refs = std::make_unique<
         InsertOnlyConcurrentMap<const DexMethod*, std::shared_ptr<CodeRefs>>>();
+    m_callee_problematic_refs = std::make_unique<InsertOnlyConcurrentMap<
+        std::pair<const DexMethod*, size_t>, bool,
+        boost::hash<std::pair<const DexMethod*, size_t>>>>();
   }
   if (m_x_dex) {
     m_callee_x_dex_refs = std::make_unique<InsertOnlyConcurrentMap<
@@ -2516,20 +2519,35 @@ bool MultiMethodInliner::problematic_refs(
     const cfg::ControlFlowGraph* reduced_cfg) {
   always_assert(caller->get_class() != callee->get_class());
   always_assert(m_ref_checkers);
-  auto callee_code_refs = get_callee_code_refs(callee, reduced_cfg);
-  always_assert(callee_code_refs);
   size_t store_idx =
       m_shrinker.get_xstores().get_store_idx(caller->get_class());
-  const auto* ref_checker =
-      m_ref_checkers
-          ->get_or_create_and_assert_equal(
-              store_idx,
-              [&](auto) {
-                const auto& xstores = m_shrinker.get_xstores();
-                return RefChecker(&xstores, store_idx, m_min_sdk_api);
-              })
-          .first;
-  if (!ref_checker->check_code_refs(*callee_code_refs)) {
+  auto check = [&]() {
+    auto callee_code_refs = get_callee_code_refs(callee, reduced_cfg);
+    always_assert(callee_code_refs);
+    const auto* ref_checker =
+        m_ref_checkers
+            ->get_or_create_and_assert_equal(
+                store_idx,
+                [&](auto) {
+                  const auto& xstores = m_shrinker.get_xstores();
+                  return RefChecker(&xstores, store_idx, m_min_sdk_api);
+                })
+            .first;
+    return !ref_checker->check_code_refs(*callee_code_refs);
+  };
+  bool problematic;
+  if (m_callee_problematic_refs && (reduced_cfg == nullptr)) {
+    // Many callers in the same store share the verdict for a callee, so avoid
+    // walking all of its refs again.
+    problematic = *m_callee_problematic_refs
+                       ->get_or_create_and_assert_equal(
+                           std::make_pair(callee, store_idx),
+                           [&](const auto&) { return check(); })
+                       .first;
+  } else {
+    problematic = check();
+  }
+  if (problematic) {
     info.problematic_refs++;
     return true;
   }
@@ -855,6 +855,15 @@ class MultiMethodInliner {
       InsertOnlyConcurrentMap<const DexMethod*, std::shared_ptr<CodeRefs>>>
       m_callee_code_refs;
 
+  // Optional cache for problematic_refs function, keyed by callee and the
+  // store index of the caller. Only the outcome of checking the callee's
+  // (unchanging) code refs in the caller's store is kept.
+  std::unique_ptr<
+      InsertOnlyConcurrentMap<std::pair<const DexMethod*, size_t>,
+                              bool,
+                              boost::hash<std::pair<const DexMethod*, size_t>>>>
+      m_callee_problematic_refs;
+
   // Optional cache for get_callee_caller_res function
   std::unique_ptr<InsertOnlyConcurrentMap<const DexMethod*, CalleeCallerRefs>>
       m_callee_caller_refs;
@@ -1227,6 +1227,8 @@ void run_inliner(
   mgr.incr_metric("blocks_eliminated_by_dedup_blocks",
                   shrinker.get_dedup_blocks_stats().blocks_removed);
   mgr.incr_metric("methods_reg_alloced", shrinker.get_methods_reg_alloced());
+  mgr.incr_metric("shared_type_inferences",
+                  shrinker.get_shared_type_inferences());
   mgr.incr_metric("localdce_init_class_instructions_added",
                   shrinker.get_local_dce_stats().init_class_instructions_added);
   mgr.incr_metric(
@@ -533,7 +533,7 @@ class PointsToSemantics final {
     return m_method_semantics;
   }
 
-  const TypeSystem& get_type_system() { return m_type_system; }
+  const TypeSystem& get_type_system() const { return m_type_system; }
 
   std::optional<PointsToMethodSemantics*> get_method_semantics(
       DexMethodRef* dex_method);
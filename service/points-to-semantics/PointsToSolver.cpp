@@ -0,0 +1,669 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PointsToSolver.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Debug.h"
+#include "Resolver.h"
+#include "Show.h"
+#include "Trace.h"
+#include "TypeUtil.h"
+#include "WorkQueue.h"
+
+namespace {
+
+// The pseudo-field holding the elements of an array.
+const char kArrayElementField = 0;
+
+const void* get_field_key(const PointsToOperation& operation) {
+  if (operation.kind == PTS_IGET_SPECIAL ||
+      operation.kind == PTS_IPUT_SPECIAL) {
+    always_assert(operation.special_edge == PTS_ARRAY_ELEMENT);
+    return &kArrayElementField;
+  }
+  auto* field = resolve_field(operation.dex_field);
+  return field != nullptr ? field : operation.dex_field;
+}
+
+bool is_null(const PointsToVariable& variable) {
+  return variable == PointsToVariable::null_variable();
+}
+
+// A sound approximation of whether an object may pass a check-cast.
+bool may_cast(const PointsToAbstractObject& object, const DexType* type) {
+  if (object.kind == PointsToAbstractObject::EXCEPTION ||
+      type::is_array(type) || type::is_array(object.type)) {
+    return true;
+  }
+  if (type::check_cast(object.type, type)) {
+    return true;
+  }
+  // A negative answer is only reliable for app-internal types.
+  auto* cls = type_class(type);
+  return cls == nullptr || cls->is_external();
+}
+
+} // namespace
+
+PointsToSolver::PointsToSolver(const PointsToSemantics& semantics)
+    : m_semantics(semantics) {
+  const auto* throwable = type::java_lang_Throwable();
+  m_exception_types.push_back(throwable);
+  const auto children = semantics.get_type_system().get_all_children(throwable);
+  m_exception_types.insert(m_exception_types.end(), children.begin(),
+                           children.end());
+  std::vector<std::pair<DexMethodRef*, const PointsToMethodSemantics*>>
+      methods;
+  methods.reserve(semantics.method_semantics().size());
+  for (const auto& entry : UnorderedIterable(semantics.method_semantics())) {
+    methods.emplace_back(entry.first, &entry.second);
+  }
+  std::sort(methods.begin(), methods.end(), [](const auto& a, const auto& b) {
+    return compare_dexmethods(a.first, b.first);
+  });
+  for (const auto& [method, method_semantics] : methods) {
+    generate_constraints(method, *method_semantics);
+  }
+  TRACE(PTA, 1,
+        "[points-to solver] %zu methods, %zu variables, %zu objects, %zu "
+        "complex constraints",
+        methods.size(), m_representative.size(), m_objects.size(),
+        m_complex_constraints.size());
+}
+
+PointsToSolver::NodeId PointsToSolver::new_node() {
+  auto node = static_cast<NodeId>(m_representative.size());
+  m_representative.push_back(node);
+  m_points_to.emplace_back();
+  m_successors.emplace_back();
+  return node;
+}
+
+PointsToSolver::NodeId PointsToSolver::get_variable_node(
+    const DexMethodRef* method, const PointsToVariable& variable) {
+  always_assert(!is_null(variable));
+  if (variable == PointsToVariable::this_variable()) {
+    return get_formal_node(method, THIS_SLOT);
+  }
+  auto [it, inserted] =
+      m_variable_nodes.emplace(std::make_pair(method, variable), 0);
+  if (inserted) {
+    it->second = new_node();
+  }
+  return it->second;
+}
+
+PointsToSolver::NodeId PointsToSolver::get_formal_node(
+    const DexMethodRef* method, int64_t slot) {
+  auto [it, inserted] = m_formal_nodes.emplace(std::make_pair(method, slot), 0);
+  if (inserted) {
+    it->second = new_node();
+  }
+  return it->second;
+}
+
+PointsToSolver::NodeId PointsToSolver::get_static_field_node(
+    const DexFieldRef* field) {
+  auto* resolved = resolve_field(field, FieldSearch::Static);
+  if (resolved != nullptr) {
+    field = resolved;
+  }
+  auto [it, inserted] = m_static_field_nodes.emplace(field, 0);
+  if (inserted) {
+    it->second = new_node();
+  }
+  return it->second;
+}
+
+PointsToSolver::NodeId PointsToSolver::get_field_node(ObjectId object,
+                                                      const void* field) {
+  auto [it, inserted] =
+      m_field_nodes.emplace(std::make_pair(object, field), 0);
+  if (inserted) {
+    it->second = new_node();
+  }
+  return it->second;
+}
+
+PointsToSolver::ObjectId PointsToSolver::new_object(
+    const PointsToAbstractObject& object) {
+  auto id = static_cast<ObjectId>(m_objects.size());
+  m_objects.push_back(object);
+  return id;
+}
+
+PointsToSolver::ObjectId PointsToSolver::get_allocation_object(
+    const DexMethodRef* method,
+    const PointsToVariable& variable,
+    const DexType* type) {
+  auto [it, inserted] =
+      m_allocation_objects.emplace(std::make_pair(method, variable), 0);
+  if (inserted) {
+    PointsToAbstractObject object{PointsToAbstractObject::ALLOCATION, type};
+    object.method = method;
+    it->second = new_object(object);
+  }
+  return it->second;
+}
+
+PointsToSolver::ObjectId PointsToSolver::get_string_object(
+    const DexString* string) {
+  auto [it, inserted] = m_string_objects.emplace(string, 0);
+  if (inserted) {
+    PointsToAbstractObject object{PointsToAbstractObject::STRING,
+                                  type::java_lang_String()};
+    object.string = string;
+    it->second = new_object(object);
+  }
+  return it->second;
+}
+
+PointsToSolver::ObjectId PointsToSolver::get_class_object(
+    const DexType* type) {
+  auto [it, inserted] = m_class_objects.emplace(type, 0);
+  if (inserted) {
+    PointsToAbstractObject object{PointsToAbstractObject::CLASS,
+                                  type::java_lang_Class()};
+    object.reflected_type = type;
+    it->second = new_object(object);
+  }
+  return it->second;
+}
+
+PointsToSolver::ObjectId PointsToSolver::get_exception_object() {
+  if (!m_exception_object) {
+    m_exception_object = new_object(PointsToAbstractObject{
+        PointsToAbstractObject::EXCEPTION, type::java_lang_Throwable()});
+  }
+  return *m_exception_object;
+}
+
+bool PointsToSolver::add_edge(NodeId from, NodeId to) {
+  from = find(from);
+  to = find(to);
+  if (from == to) {
+    return false;
+  }
+  if (!m_edges.insert((static_cast<uint64_t>(from) << 32) | to).second) {
+    return false;
+  }
+  m_successors[from].push_back(to);
+  return true;
+}
+
+bool PointsToSolver::add_object(NodeId node, ObjectId object) {
+  auto& points_to = m_points_to[find(node)];
+  if (points_to.contains(object)) {
+    return false;
+  }
+  points_to.insert(object);
+  return true;
+}
+
+void PointsToSolver::generate_constraints(
+    const DexMethodRef* method, const PointsToMethodSemantics& semantics) {
+  const auto var = [&](const PointsToVariable& v) {
+    return get_variable_node(method, v);
+  };
+  for (const auto& action : semantics.get_points_to_actions()) {
+    const auto& operation = action.operation();
+    if (operation.is_invoke()) {
+      generate_invoke_constraints(method, action);
+      continue;
+    }
+    switch (operation.kind) {
+    case PTS_CONST_STRING: {
+      add_object(var(action.dest()), get_string_object(operation.dex_string));
+      break;
+    }
+    case PTS_CONST_CLASS: {
+      add_object(var(action.dest()), get_class_object(operation.dex_type));
+      break;
+    }
+    case PTS_GET_EXCEPTION: {
+      add_object(var(action.dest()), get_exception_object());
+      break;
+    }
+    case PTS_NEW_OBJECT: {
+      add_object(var(action.dest()),
+                 get_allocation_object(method, action.dest(),
+                                       operation.dex_type));
+      break;
+    }
+    case PTS_LOAD_PARAM: {
+      add_edge(get_formal_node(method, operation.parameter),
+               var(action.dest()));
+      break;
+    }
+    case PTS_GET_CLASS: {
+      if (!is_null(action.src())) {
+        m_complex_constraints.push_back(
+            ComplexConstraint{ConstraintKind::GET_CLASS, var(action.src()),
+                              var(action.dest())});
+      }
+      break;
+    }
+    case PTS_CHECK_CAST: {
+      if (!is_null(action.src())) {
+        ComplexConstraint constraint{ConstraintKind::CHECK_CAST,
+                                     var(action.src()), var(action.dest())};
+        constraint.type = operation.dex_type;
+        m_complex_constraints.push_back(std::move(constraint));
+      }
+      break;
+    }
+    case PTS_IGET:
+    case PTS_IGET_SPECIAL: {
+      if (!is_null(action.instance())) {
+        ComplexConstraint constraint{ConstraintKind::LOAD,
+                                     var(action.instance()),
+                                     var(action.dest())};
+        constraint.field = get_field_key(operation);
+        m_complex_constraints.push_back(std::move(constraint));
+      }
+      break;
+    }
+    case PTS_SGET: {
+      add_edge(get_static_field_node(operation.dex_field), var(action.dest()));
+      break;
+    }
+    case PTS_IPUT:
+    case PTS_IPUT_SPECIAL: {
+      if (!is_null(action.lhs()) && !is_null(action.rhs())) {
+        ComplexConstraint constraint{ConstraintKind::STORE, var(action.lhs()),
+                                     var(action.rhs())};
+        constraint.field = get_field_key(operation);
+        m_complex_constraints.push_back(std::move(constraint));
+      }
+      break;
+    }
+    case PTS_SPUT: {
+      if (!is_null(action.rhs())) {
+        add_edge(var(action.rhs()), get_static_field_node(operation.dex_field));
+      }
+      break;
+    }
+    case PTS_RETURN: {
+      if (!is_null(action.src())) {
+        add_edge(var(action.src()), get_formal_node(method, RETURN_SLOT));
+      }
+      break;
+    }
+    case PTS_DISJUNCTION: {
+      auto dest = var(action.dest());
+      for (const auto& arg : action.get_arguments()) {
+        if (!is_null(arg.second)) {
+          add_edge(var(arg.second), dest);
+        }
+      }
+      break;
+    }
+    default: {
+      not_reached_log("Unexpected points-to operation %d", operation.kind);
+    }
+    }
+  }
+}
+
+void PointsToSolver::generate_invoke_constraints(const DexMethodRef* method,
+                                                 const PointsToAction& action) {
+  const auto& operation = action.operation();
+  Call call{&action, operation.dex_method,
+            operation.kind == PTS_INVOKE_INTERFACE};
+  if (action.has_dest()) {
+    call.dest = get_variable_node(method, action.dest());
+  }
+  for (const auto& arg : action.get_arguments()) {
+    if (!is_null(arg.second)) {
+      call.args.emplace_back(arg.first, get_variable_node(method, arg.second));
+    }
+  }
+  std::optional<NodeId> instance;
+  if (operation.kind != PTS_INVOKE_STATIC && !is_null(action.instance())) {
+    instance = get_variable_node(method, action.instance());
+  }
+
+  if (operation.kind == PTS_INVOKE_VIRTUAL ||
+      operation.kind == PTS_INVOKE_INTERFACE) {
+    if (!instance) {
+      // The call always throws a NullPointerException.
+      return;
+    }
+    ComplexConstraint constraint{ConstraintKind::VIRTUAL_CALL, *instance,
+                                 *instance};
+    constraint.call = m_calls.size();
+    m_calls.push_back(std::move(call));
+    m_complex_constraints.push_back(std::move(constraint));
+    return;
+  }
+
+  // Other calls are resolved statically.
+  DexMethod* target = nullptr;
+  switch (operation.kind) {
+  case PTS_INVOKE_STATIC:
+    target = resolve_method(operation.dex_method, MethodSearch::Static);
+    break;
+  case PTS_INVOKE_DIRECT:
+    target = resolve_method(operation.dex_method, MethodSearch::Direct);
+    break;
+  case PTS_INVOKE_SUPER:
+    target = resolve_method(operation.dex_method, MethodSearch::Super,
+                            method->as_def());
+    break;
+  default:
+    not_reached();
+  }
+  auto& targets = m_call_targets[&action];
+  if (target == nullptr) {
+    return;
+  }
+  targets.push_back(target);
+  auto call_index = m_calls.size();
+  m_calls.push_back(std::move(call));
+  bind_call(call_index, target);
+  if (instance) {
+    add_edge(*instance, get_formal_node(target, THIS_SLOT));
+  }
+}
+
+bool PointsToSolver::bind_call(size_t call_index, const DexMethod* target) {
+  auto& call = m_calls[call_index];
+  if (!call.targets.insert(target).second) {
+    return false;
+  }
+  bool changed = false;
+  for (const auto& [position, node] : call.args) {
+    changed |=
+        add_edge(node, get_formal_node(target, static_cast<int64_t>(position)));
+  }
+  if (call.dest) {
+    changed |= add_edge(get_formal_node(target, RETURN_SLOT), *call.dest);
+  }
+  return changed;
+}
+
+void PointsToSolver::solve() {
+  while (true) {
+    ++m_num_rounds;
+    std::vector<NodeId> topological_order;
+    collapse_cycles(&topological_order);
+    propagate(topological_order);
+    if (!process_complex_constraints()) {
+      break;
+    }
+  }
+
+  for (const auto& call : m_calls) {
+    auto& targets = m_call_targets[call.action];
+    if (!targets.empty()) {
+      // Statically resolved.
+      continue;
+    }
+    insert_unordered_iterable(targets, targets.end(), call.targets);
+    std::sort(targets.begin(), targets.end(), compare_dexmethods);
+  }
+
+  size_t num_components = 0;
+  for (NodeId node = 0; node < m_representative.size(); ++node) {
+    num_components += find(node) == node;
+  }
+  TRACE(PTA, 1,
+        "[points-to solver] solved in %zu rounds, %zu nodes in %zu components",
+        m_num_rounds, m_representative.size(), num_components);
+}
+
+void PointsToSolver::collapse_cycles(std::vector<NodeId>* topological_order) {
+  // Tarjan's algorithm, iteratively. The components are found in reverse
+  // topological order.
+  constexpr NodeId kUnvisited = std::numeric_limits<NodeId>::max();
+  const auto num_nodes = static_cast<NodeId>(m_representative.size());
+  std::vector<NodeId> index(num_nodes, kUnvisited);
+  std::vector<NodeId> lowlink(num_nodes, 0);
+  std::vector<bool> on_stack(num_nodes, false);
+  std::vector<NodeId> stack;
+  std::vector<std::pair<NodeId, size_t>> dfs;
+  NodeId next_index = 0;
+  std::vector<NodeId> components;
+
+  const auto visit = [&](NodeId node) {
+    index[node] = lowlink[node] = next_index++;
+    stack.push_back(node);
+    on_stack[node] = true;
+    dfs.emplace_back(node, 0);
+  };
+
+  for (NodeId root = 0; root < num_nodes; ++root) {
+    if (find(root) != root || index[root] != kUnvisited) {
+      continue;
+    }
+    visit(root);
+    while (!dfs.empty()) {
+      auto node = dfs.back().first;
+      auto& position = dfs.back().second;
+      const auto& successors = m_successors[node];
+      if (position < successors.size()) {
+        auto successor = find(successors[position++]);
+        if (index[successor] == kUnvisited) {
+          visit(successor);
+        } else if (on_stack[successor]) {
+          lowlink[node] = std::min(lowlink[node], index[successor]);
+        }
+        continue;
+      }
+      dfs.pop_back();
+      if (!dfs.empty()) {
+        auto parent = dfs.back().first;
+        lowlink[parent] = std::min(lowlink[parent], lowlink[node]);
+      }
+      if (lowlink[node] != index[node]) {
+        continue;
+      }
+      // The node is the root of a component, which we merge into it.
+      components.push_back(node);
+      NodeId member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        on_stack[member] = false;
+        if (member == node) {
+          continue;
+        }
+        m_representative[member] = node;
+        m_points_to[node].union_with(m_points_to[member]);
+        m_points_to[member].clear();
+        auto& successors_of_node = m_successors[node];
+        auto& successors_of_member = m_successors[member];
+        successors_of_node.insert(successors_of_node.end(),
+                                  successors_of_member.begin(),
+                                  successors_of_member.end());
+        successors_of_member.clear();
+        successors_of_member.shrink_to_fit();
+      } while (member != node);
+    }
+  }
+
+  // Representatives merged in this round have themselves been merged, but
+  // not further.
+  for (NodeId node = 0; node < num_nodes; ++node) {
+    m_representative[node] = m_representative[m_representative[node]];
+  }
+  for (auto node : components) {
+    auto& successors = m_successors[node];
+    for (auto& successor : successors) {
+      successor = find(successor);
+    }
+    std::sort(successors.begin(), successors.end());
+    successors.erase(std::unique(successors.begin(), successors.end()),
+                     successors.end());
+    successors.erase(
+        std::remove(successors.begin(), successors.end(), node),
+        successors.end());
+  }
+  topological_order->assign(components.rbegin(), components.rend());
+}
+
+void PointsToSolver::propagate(const std::vector<NodeId>& topological_order) {
+  for (auto node : topological_order) {
+    const auto& points_to = m_points_to[node];
+    if (points_to.empty()) {
+      continue;
+    }
+    for (auto successor : m_successors[node]) {
+      m_points_to[successor].union_with(points_to);
+    }
+  }
+}
+
+bool PointsToSolver::process_complex_constraints() {
+  std::vector<Effects> effects(m_complex_constraints.size());
+  workqueue_run_for<size_t>(0, m_complex_constraints.size(), [&](size_t i) {
+    effects[i] = process_complex_constraint(m_complex_constraints[i]);
+  });
+
+  bool changed = false;
+  for (size_t i = 0; i < effects.size(); ++i) {
+    const auto& constraint_effects = effects[i];
+    for (const auto& [from, field] : constraint_effects.stores) {
+      changed |= add_edge(from, get_field_node(field.first, field.second));
+    }
+    for (const auto& [field, to] : constraint_effects.loads) {
+      changed |= add_edge(get_field_node(field.first, field.second), to);
+    }
+    for (const auto& [node, object] : constraint_effects.objects) {
+      changed |= add_object(node, object);
+    }
+    for (const auto& [node, type] : constraint_effects.class_objects) {
+      changed |= add_object(node, get_class_object(type));
+    }
+    for (const auto& [target, receiver] : constraint_effects.targets) {
+      changed |= bind_call(m_complex_constraints[i].call, target);
+      changed |= add_object(get_formal_node(target, THIS_SLOT), receiver);
+    }
+  }
+  return changed;
+}
+
+PointsToSolver::Effects PointsToSolver::process_complex_constraint(
+    ComplexConstraint& constraint) const {
+  Effects effects;
+  auto points_to = m_points_to[find(constraint.base)];
+  auto delta = points_to;
+  delta.difference_with(constraint.processed);
+  if (delta.empty()) {
+    return effects;
+  }
+  constraint.processed = std::move(points_to);
+
+  for (auto object_id : delta) {
+    const auto& object = m_objects[object_id];
+    switch (constraint.kind) {
+    case ConstraintKind::LOAD: {
+      effects.loads.emplace_back(std::make_pair(object_id, constraint.field),
+                                 constraint.other);
+      break;
+    }
+    case ConstraintKind::STORE: {
+      effects.stores.emplace_back(constraint.other,
+                                  std::make_pair(object_id, constraint.field));
+      break;
+    }
+    case ConstraintKind::CHECK_CAST: {
+      if (may_cast(object, constraint.type)) {
+        effects.objects.emplace_back(constraint.other, object_id);
+      }
+      break;
+    }
+    case ConstraintKind::GET_CLASS: {
+      if (object.kind == PointsToAbstractObject::EXCEPTION) {
+        for (const auto* type : m_exception_types) {
+          effects.class_objects.emplace_back(constraint.other, type);
+        }
+        break;
+      }
+      effects.class_objects.emplace_back(constraint.other, object.type);
+      break;
+    }
+    case ConstraintKind::VIRTUAL_CALL: {
+      const auto& call = m_calls[constraint.call];
+      const auto dispatch = [&](const DexType* type) -> const DexMethod* {
+        auto* cls = type_class(type);
+        if (cls == nullptr) {
+          return nullptr;
+        }
+        return resolve_method(cls, call.callee->get_name(),
+                              call.callee->get_proto(),
+                              call.is_interface
+                                  ? MethodSearch::InterfaceVirtual
+                                  : MethodSearch::Virtual);
+      };
+      if (object.kind == PointsToAbstractObject::EXCEPTION) {
+        // The exception object may be of any subclass of java.lang.Throwable,
+        // so the call may reach any override.
+        UnorderedSet<const DexMethod*> targets;
+        for (const auto* type : m_exception_types) {
+          const auto* target = dispatch(type);
+          if (target != nullptr && targets.insert(target).second) {
+            effects.targets.emplace_back(target, object_id);
+          }
+        }
+        break;
+      }
+      const auto* target = dispatch(object.type);
+      if (target != nullptr) {
+        effects.targets.emplace_back(target, object_id);
+      }
+      break;
+    }
+    }
+  }
+  return effects;
+}
+
+PointsToSolver::ObjectSet PointsToSolver::get_points_to(
+    const DexMethodRef* method, const PointsToVariable& variable) const {
+  if (is_null(variable)) {
+    return ObjectSet();
+  }
+  if (variable == PointsToVariable::this_variable()) {
+    auto it = m_formal_nodes.find(std::make_pair(method, THIS_SLOT));
+    return it == m_formal_nodes.end() ? ObjectSet()
+                                      : m_points_to[find(it->second)];
+  }
+  auto it = m_variable_nodes.find(std::make_pair(method, variable));
+  return it == m_variable_nodes.end() ? ObjectSet()
+                                      : m_points_to[find(it->second)];
+}
+
+PointsToSolver::ObjectSet PointsToSolver::get_static_field_points_to(
+    const DexFieldRef* field) const {
+  auto* resolved = resolve_field(field, FieldSearch::Static);
+  if (resolved != nullptr) {
+    field = resolved;
+  }
+  auto it = m_static_field_nodes.find(field);
+  return it == m_static_field_nodes.end() ? ObjectSet()
+                                          : m_points_to[find(it->second)];
+}
+
+bool PointsToSolver::may_alias(const DexMethodRef* method1,
+                               const PointsToVariable& variable1,
+                               const DexMethodRef* method2,
+                               const PointsToVariable& variable2) const {
+  auto points_to = get_points_to(method1, variable1);
+  points_to.intersection_with(get_points_to(method2, variable2));
+  return !points_to.empty();
+}
+
+const std::vector<const DexMethod*>& PointsToSolver::get_call_targets(
+    const PointsToAction* invoke) const {
+  static const std::vector<const DexMethod*> no_targets;
+  auto it = m_call_targets.find(invoke);
+  return it == m_call_targets.end() ? no_targets : it->second;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <sparta/PatriciaTreeSet.h>
+
+#include "DeterministicContainers.h"
+#include "DexClass.h"
+#include "PointsToSemantics.h"
+
+/*
+ * An abstract object instance of the points-to analysis. Objects are
+ * abstracted by allocation site for `new` operations, and by value for string
+ * and class constants. All exceptions caught by the program are abstracted by
+ * a single object, which may be an instance of java.lang.Throwable or of any of
+ * its subclasses.
+ */
+struct PointsToAbstractObject {
+  enum Kind : uint8_t {
+    ALLOCATION, // An object created by PTS_NEW_OBJECT
+    STRING, // A string constant
+    CLASS, // A java.lang.Class object
+    EXCEPTION, // Any exception obtained by PTS_GET_EXCEPTION
+  };
+
+  Kind kind;
+  // The dynamic type of the object. For EXCEPTION objects, this is
+  // java.lang.Throwable, which stands for any of its subclasses.
+  const DexType* type;
+  // The type reflected by a CLASS object.
+  const DexType* reflected_type{nullptr};
+  // The method performing the allocation, for ALLOCATION objects.
+  const DexMethodRef* method{nullptr};
+  // The string value, for STRING objects.
+  const DexString* string{nullptr};
+};
+
+/*
+ * A whole-program, flow-insensitive and context-insensitive points-to analysis
+ * in the style of Andersen, which solves the system of points-to equations
+ * produced by PointsToSemantics. Fields are handled field-sensitively, i.e.,
+ * there is one set of objects per abstract object and field.
+ *
+ * Points-to sets are sets of abstract object ids represented as hash-consed
+ * Patricia trees, so that equal sets share their representation and can be
+ * compared and joined in constant time when they are equal.
+ *
+ * The solver follows the wave propagation scheme:
+ *
+ *   F. Pereira, D. Berlin. Wave Propagation and Deep Propagation for Pointer
+ *   Analysis. In CGO (2009).
+ *
+ * Each round (1) collapses the strongly connected components of the graph of
+ * inclusion constraints, whose variables must have the same points-to set,
+ * (2) propagates points-to sets along the resulting DAG in topological order,
+ * and (3) processes the complex constraints (field accesses, virtual calls,
+ * casts) against the objects that appeared since the previous round, in
+ * parallel. The rounds stop when (3) does not add any new inclusion
+ * constraint.
+ *
+ * All methods are considered reachable, and calls to methods without points-to
+ * semantics (external methods without stubs) have no effect.
+ */
+class PointsToSolver final {
+ public:
+  using ObjectId = uint32_t;
+  using ObjectSet = sparta::HashConsedPatriciaTreeSet<ObjectId>;
+
+  explicit PointsToSolver(const PointsToSemantics& semantics);
+
+  PointsToSolver(const PointsToSolver&) = delete;
+  PointsToSolver& operator=(const PointsToSolver&) = delete;
+
+  void solve();
+
+  /*
+   * The abstract objects that a points-to variable of the given method may
+   * point to.
+   */
+  ObjectSet get_points_to(const DexMethodRef* method,
+                          const PointsToVariable& variable) const;
+
+  /*
+   * The abstract objects that a static field may point to.
+   */
+  ObjectSet get_static_field_points_to(const DexFieldRef* field) const;
+
+  bool may_alias(const DexMethodRef* method1,
+                 const PointsToVariable& variable1,
+                 const DexMethodRef* method2,
+                 const PointsToVariable& variable2) const;
+
+  const PointsToAbstractObject& get_object(ObjectId id) const {
+    return m_objects.at(id);
+  }
+
+  /*
+   * The methods that an invoke action of the points-to semantics may call,
+   * sorted by method. For virtual calls, these are the overriding methods
+   * selected by the dynamic types of the objects the receiver points to.
+   */
+  const std::vector<const DexMethod*>& get_call_targets(
+      const PointsToAction* invoke) const;
+
+  size_t num_rounds() const { return m_num_rounds; }
+
+ private:
+  using NodeId = uint32_t;
+
+  enum class ConstraintKind : uint8_t {
+    LOAD, // dest = base.field
+    STORE, // base.field = src
+    VIRTUAL_CALL, // dest = base.method(args)
+    CHECK_CAST, // dest = (type) base
+    GET_CLASS, // dest = base.getClass()
+  };
+
+  /*
+   * A constraint whose effect depends on the points-to set of its base
+   * variable.
+   */
+  struct ComplexConstraint {
+    ConstraintKind kind;
+    NodeId base;
+    // The destination of loads, casts and getClass, the source of stores.
+    NodeId other;
+    // The field of loads and stores.
+    const void* field{nullptr};
+    // The target type of casts.
+    const DexType* type{nullptr};
+    // The call of virtual calls.
+    size_t call{0};
+    // The objects of the base variable processed so far.
+    ObjectSet processed;
+  };
+
+  /*
+   * The outcome of processing a complex constraint, computed in parallel and
+   * applied sequentially.
+   */
+  struct Effects {
+    // Inclusion constraints from the first node to the field node of the
+    // object, or from the field node of the object to the second node.
+    std::vector<std::pair<NodeId, std::pair<ObjectId, const void*>>> stores;
+    std::vector<std::pair<std::pair<ObjectId, const void*>, NodeId>> loads;
+    // Objects added to the points-to set of a node.
+    std::vector<std::pair<NodeId, ObjectId>> objects;
+    // Class objects added to the points-to set of a node.
+    std::vector<std::pair<NodeId, const DexType*>> class_objects;
+    // Call targets and receivers of virtual calls.
+    std::vector<std::pair<const DexMethod*, ObjectId>> targets;
+  };
+
+  struct Call {
+    const PointsToAction* action;
+    const DexMethodRef* callee;
+    bool is_interface;
+    std::optional<NodeId> dest;
+    std::vector<std::pair<size_t, NodeId>> args;
+    UnorderedSet<const DexMethod*> targets;
+  };
+
+  // The formal slots of a method, besides its parameters.
+  static constexpr int64_t THIS_SLOT = -1;
+  static constexpr int64_t RETURN_SLOT = -2;
+
+  NodeId new_node();
+  NodeId get_variable_node(const DexMethodRef* method,
+                           const PointsToVariable& variable);
+  NodeId get_formal_node(const DexMethodRef* method, int64_t slot);
+  NodeId get_static_field_node(const DexFieldRef* field);
+  NodeId get_field_node(ObjectId object, const void* field);
+  ObjectId new_object(const PointsToAbstractObject& object);
+  ObjectId get_allocation_object(const DexMethodRef* method,
+                                 const PointsToVariable& variable,
+                                 const DexType* type);
+  ObjectId get_string_object(const DexString* string);
+  ObjectId get_class_object(const DexType* type);
+  ObjectId get_exception_object();
+
+  void generate_constraints(const DexMethodRef* method,
+                            const PointsToMethodSemantics& semantics);
+  void generate_invoke_constraints(const DexMethodRef* method,
+                                   const PointsToAction& action);
+  bool bind_call(size_t call_index, const DexMethod* target);
+  bool add_edge(NodeId from, NodeId to);
+  bool add_object(NodeId node, ObjectId object);
+
+  void collapse_cycles(std::vector<NodeId>* topological_order);
+  void propagate(const std::vector<NodeId>& topological_order);
+  bool process_complex_constraints();
+  Effects process_complex_constraint(ComplexConstraint& constraint) const;
+
+  NodeId find(NodeId node) const { return m_representative[node]; }
+
+  const PointsToSemantics& m_semantics;
+
+  // Nodes are merged by cycle elimination, each node points to the
+  // representative of its component.
+  std::vector<NodeId> m_representative;
+  std::vector<ObjectSet> m_points_to;
+  std::vector<std::vector<NodeId>> m_successors;
+  UnorderedSet<uint64_t> m_edges;
+
+  std::vector<PointsToAbstractObject> m_objects;
+  UnorderedMap<std::pair<const DexMethodRef*, PointsToVariable>,
+               ObjectId,
+               boost::hash<std::pair<const DexMethodRef*, PointsToVariable>>>
+      m_allocation_objects;
+  UnorderedMap<const DexString*, ObjectId> m_string_objects;
+  UnorderedMap<const DexType*, ObjectId> m_class_objects;
+  std::optional<ObjectId> m_exception_object;
+  // The possible dynamic types of the exception object: java.lang.Throwable
+  // and all its subclasses, in depth-first pre-order.
+  std::vector<const DexType*> m_exception_types;
+
+  UnorderedMap<std::pair<const DexMethodRef*, PointsToVariable>,
+               NodeId,
+               boost::hash<std::pair<const DexMethodRef*, PointsToVariable>>>
+      m_variable_nodes;
+  UnorderedMap<std::pair<const DexMethodRef*, int64_t>,
+               NodeId,
+               boost::hash<std::pair<const DexMethodRef*, int64_t>>>
+      m_formal_nodes;
+  UnorderedMap<const DexFieldRef*, NodeId> m_static_field_nodes;
+  UnorderedMap<std::pair<ObjectId, const void*>,
+               NodeId,
+               boost::hash<std::pair<ObjectId, const void*>>>
+      m_field_nodes;
+
+  std::vector<ComplexConstraint> m_complex_constraints;
+  std::vector<Call> m_calls;
+  UnorderedMap<const PointsToAction*, std::vector<const DexMethod*>>
+      m_call_targets;
+  size_t m_num_rounds{0};
+};
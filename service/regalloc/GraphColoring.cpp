@@ -795,7 +795,7 @@ UnorderedMap<reg_t, cfg::InstructionIterator> Allocator::find_param_splits(
   }
 
   cfg::Block* start_block = cfg.entry_block();
-  auto doms = dominators::SimpleFastDominators<cfg::GraphInterface>(cfg);
+  const auto& doms = cfg.get_dominators();
   for (auto param : UnorderedIterable(params)) {
     auto block_uses = find_first_uses(param, start_block);
     // Since this function only gets called for param regs that need to be
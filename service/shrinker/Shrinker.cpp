@@ -230,6 +230,10 @@ void Shrinker::shrink_code(
   LocalDce::Stats local_dce_stats;
   dedup_blocks_impl::Stats dedup_blocks_stats;
   size_t branch_prefix_hoisting_stats{0};
+  size_t shared_type_inferences{0};
+  // A type inference of the current cfg, handed from one step to the next
+  // while no step in between changes the cfg.
+  std::unique_ptr<type_inference::TypeInference> type_inference;
 
   code->build_cfg();
   if (m_config.run_const_prop) {
@@ -322,19 +326,17 @@ void Shrinker::shrink_code(
         &config, code, is_static, declaring_type, proto->get_args());
     dedup_blocks.run();
     dedup_blocks_stats = dedup_blocks.get_stats();
+    type_inference = dedup_blocks.release_type_inference();
   }
 
   if (m_config.run_branch_prefix_hoisting) {
     auto timer = m_branch_prefix_hoisting_timer.scope();
-    auto& cfg = code->cfg();
-    Lazy<const constant_uses::ConstantUses> constant_uses([&] {
-      return std::make_unique<const constant_uses::ConstantUses>(
-          cfg, is_static, declaring_type, proto->get_rtype(), proto->get_args(),
-          method_describer,
-          /* force_type_inference */ true);
-    });
+    if (type_inference) {
+      shared_type_inferences = 1;
+    }
     branch_prefix_hoisting_stats = branch_prefix_hoisting_impl::process_cfg(
-        cfg, constant_uses, /* can_allocate_regs */ true);
+        code->cfg(), is_static, declaring_type, proto, method_describer,
+        std::move(type_inference), /* can_allocate_regs */ true);
   }
 
   auto data_after_dedup = get_features(kMMINLDataCollectionLevel);
@@ -357,6 +359,7 @@ void Shrinker::shrink_code(
   m_methods_shrunk++;
   m_methods_reg_alloced += reg_alloc_inc;
   m_branch_prefix_hoisting_stats += branch_prefix_hoisting_stats;
+  m_shared_type_inferences += shared_type_inferences;
 }
 
 void Shrinker::log_metrics(ScopedMetrics& sm) const {
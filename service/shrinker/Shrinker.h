@@ -86,6 +86,11 @@ class Shrinker {
   size_t get_branch_prefix_hoisting_stats() const {
     return m_branch_prefix_hoisting_stats;
   }
+  // The number of type inferences that one shrinking step reused from the
+  // previous one, instead of recomputing them for the same cfg.
+  size_t get_shared_type_inferences() const {
+    return m_shared_type_inferences;
+  }
   size_t get_methods_shrunk() const { return m_methods_shrunk; }
   size_t get_methods_reg_alloced() const { return m_methods_reg_alloced; }
 
@@ -196,6 +201,7 @@ class Shrinker {
   AccumulatingTimer m_reg_alloc_timer;
   size_t m_methods_shrunk{0};
   size_t m_methods_reg_alloced{0};
+  size_t m_shared_type_inferences{0};
 };
 
 } // namespace shrinker
@@ -26,11 +26,10 @@ const DexString* get_deobfuscated_name_dex_string(const DexMember* member) {
 
 template <>
 const DexString* get_deobfuscated_name_dex_string(const DexField* member) {
-  const auto& str = member->get_deobfuscated_name();
-  if (str.empty()) {
+  if (member->get_deobfuscated_name_or_empty().empty()) {
     return nullptr;
   }
-  return DexString::make_string(str);
+  return member->get_deobfuscated_name_or_null();
 }
 } // namespace
 
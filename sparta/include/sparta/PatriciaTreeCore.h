@@ -12,9 +12,11 @@
 #include <cstdint>
 #include <iterator>
 #include <limits>
+#include <mutex>
 #include <stack>
 #include <tuple>
 #include <type_traits>
+#include <unordered_set>
 #include <utility>
 
 #include <boost/functional/hash.hpp>
@@ -93,12 +95,50 @@ struct EmptyValue {
       AbstractValueKind::Value;
 };
 
+/*
+ * The empty value of hash-consed sets.
+ *
+ * A value interface opts into hash-consing by declaring:
+ *
+ *   // Intern every node of the tree in a global node table.
+ *   constexpr static bool hash_consed = true;
+ *
+ *   // A hash function consistent with `equals`.
+ *   static size_t hash(const type& x);
+ *
+ * Structurally equal trees are then always represented by the same root node,
+ * which makes `equals` a pointer comparison and lets the pointer shortcuts of
+ * leq, join and meet apply to independently constructed trees. In exchange,
+ * every node creation goes through a (sharded) lock of the node table.
+ */
+struct HashConsedEmptyValue final : public EmptyValue {
+  constexpr static bool hash_consed = true;
+
+  static size_t hash(const type&) { return 0; }
+};
+
+template <typename Value>
+constexpr bool is_empty_value_v = std::is_base_of_v<EmptyValue, Value>;
+
+template <typename Value, typename = void>
+struct is_hash_consed : std::false_type {};
+
+template <typename Value>
+struct is_hash_consed<Value, std::void_t<decltype(Value::hash_consed)>>
+    : std::bool_constant<Value::hash_consed> {};
+
+template <typename Value>
+constexpr bool is_hash_consed_v = is_hash_consed<Value>::value;
+
 template <typename IntegerType, typename Value>
 class PatriciaTreeLeaf;
 
 template <typename IntegerType, typename Value>
 class PatriciaTreeBranch;
 
+template <typename Node>
+class PatriciaTreeNodeTable;
+
 /*
  * Base node common to branches and leafs.
  */
@@ -160,12 +200,26 @@ class PatriciaTreeNode {
     p->m_reference_count.fetch_add(1, std::memory_order_relaxed);
   }
 
-  static void intrusive_ptr_delete_leaf(const PatriciaTreeNode* p) {
-    delete static_cast<const LeafType*>(p);
+  static void intrusive_ptr_delete_leaf(const PatriciaTreeNode* p,
+                                        bool is_interned) {
+    const auto* leaf = static_cast<const LeafType*>(p);
+    if constexpr (is_hash_consed_v<Value>) {
+      if (is_interned) {
+        PatriciaTreeNodeTable<LeafType>::get().erase(leaf);
+      }
+    }
+    delete leaf;
   }
 
-  static void intrusive_ptr_delete_branch(const PatriciaTreeNode* p) {
-    delete static_cast<const BranchType*>(p);
+  static void intrusive_ptr_delete_branch(const PatriciaTreeNode* p,
+                                          bool is_interned) {
+    const auto* branch = static_cast<const BranchType*>(p);
+    if constexpr (is_hash_consed_v<Value>) {
+      if (is_interned) {
+        PatriciaTreeNodeTable<BranchType>::get().erase(branch);
+      }
+    }
+    delete branch;
   }
 
   static void intrusive_ptr_delete(const PatriciaTreeNode* p) {
@@ -178,34 +232,154 @@ class PatriciaTreeNode {
     size_t reference_count =
         p->m_reference_count.load(std::memory_order_relaxed);
     const bool is_leaf = reference_count & LEAF_MASK;
+    const bool is_interned = reference_count & INTERNED_MASK;
 
     std::atomic_thread_fence(std::memory_order_acquire);
     if (is_leaf) {
-      intrusive_ptr_delete_leaf(p);
+      intrusive_ptr_delete_leaf(p, is_interned);
     } else {
-      intrusive_ptr_delete_branch(p);
+      intrusive_ptr_delete_branch(p, is_interned);
     }
   }
 
   friend void intrusive_ptr_release(const PatriciaTreeNode* p) {
     size_t prev_reference_count =
         p->m_reference_count.fetch_sub(1, std::memory_order_release);
-    const bool is_unique = (prev_reference_count & ~LEAF_MASK) == 1;
+    const bool is_unique = (prev_reference_count & COUNT_MASK) == 1;
     if (is_unique) {
       intrusive_ptr_delete(p);
     }
   }
 
+  // Only used by the node table of hash-consed trees, under its lock. A node
+  // whose reference count already dropped to zero is about to be deleted and
+  // must not be resurrected.
+  bool try_add_ref() const {
+    size_t reference_count = m_reference_count.load(std::memory_order_relaxed);
+    do {
+      if ((reference_count & COUNT_MASK) == 0) {
+        return false;
+      }
+    } while (!m_reference_count.compare_exchange_weak(
+        reference_count, reference_count + 1, std::memory_order_relaxed));
+    return true;
+  }
+
+  void set_interned() const {
+    m_reference_count.fetch_or(INTERNED_MASK, std::memory_order_relaxed);
+  }
+
+  template <typename Node>
+  friend class PatriciaTreeNodeTable;
+
   // We are stealing the highest bit of our reference counter to indicate
-  // whether this tree is a leaf (or, otherwise, branch).
+  // whether this tree is a leaf (or, otherwise, branch), and the next one to
+  // indicate whether it is registered in the node table of hash-consed trees.
   static constexpr size_t LEAF_MASK = ~(static_cast<size_t>(-1) >> 1);
+  static constexpr size_t INTERNED_MASK = LEAF_MASK >> 1;
+  static constexpr size_t COUNT_MASK = ~(LEAF_MASK | INTERNED_MASK);
   mutable std::atomic<size_t> m_reference_count;
 };
 
+/*
+ * The table through which the nodes of hash-consed trees are interned. Since
+ * children are interned before their parents, nodes are compared shallowly,
+ * i.e., branches compare their subtrees by pointer.
+ *
+ * The table does not hold references: a node erases itself from the table
+ * when its reference count drops to zero. The table is sharded by hash to
+ * reduce contention when trees are built concurrently.
+ */
+template <typename Node>
+class PatriciaTreeNodeTable final {
+ public:
+  static PatriciaTreeNodeTable& get() {
+    // Intentionally leaked, as trees may be released during static
+    // destruction.
+    static auto* table = new PatriciaTreeNodeTable();
+    return *table;
+  }
+
+  // Takes ownership of the newly created `node`, and returns either it or the
+  // existing node structurally equal to it. Either way, the returned node
+  // carries the reference of the caller.
+  Node* intern(Node* node) {
+    Node* existing = nullptr;
+    {
+      auto& shard = get_shard(node->hash());
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.nodes.find(node);
+      if (it != shard.nodes.end()) {
+        if ((*it)->try_add_ref()) {
+          existing = *it;
+        } else {
+          // The existing node is being deleted concurrently. Its owner will
+          // notice that it has been replaced when trying to erase it.
+          shard.nodes.erase(it);
+        }
+      }
+      if (existing == nullptr) {
+        node->set_interned();
+        shard.nodes.insert(node);
+        return node;
+      }
+    }
+    delete node;
+    return existing;
+  }
+
+  // Called when the reference count of an interned node dropped to zero.
+  void erase(const Node* node) {
+    auto& shard = get_shard(node->hash());
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.nodes.find(const_cast<Node*>(node));
+    if (it != shard.nodes.end() && *it == node) {
+      shard.nodes.erase(it);
+    }
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (auto& shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      size += shard.nodes.size();
+    }
+    return size;
+  }
+
+ private:
+  struct NodeHash {
+    size_t operator()(const Node* node) const { return node->hash(); }
+  };
+
+  struct NodeEqual {
+    bool operator()(const Node* x, const Node* y) const {
+      return x->shallow_equals(*y);
+    }
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_set<Node*, NodeHash, NodeEqual> nodes;
+  };
+
+  static constexpr size_t NUM_SHARDS = 64;
+
+  PatriciaTreeNodeTable() = default;
+
+  Shard& get_shard(size_t hash) {
+    return m_shards[(hash ^ (hash >> 16)) % NUM_SHARDS];
+  }
+
+  Shard m_shards[NUM_SHARDS];
+};
+
 /*
  * The base of leaf nodes optionally storing a value.
  */
-template <typename IntegerType, typename Value>
+template <typename IntegerType,
+          typename Value,
+          bool IsEmpty = is_empty_value_v<Value>>
 class PatriciaTreeLeafBase {
  public:
   using ValueType = typename Value::type;
@@ -217,7 +391,20 @@ class PatriciaTreeLeafBase {
 
   const ValueType& value() const { return m_pair.second; }
 
-  constexpr size_t hash() const { return 0; }
+  size_t hash() const {
+    if constexpr (is_hash_consed_v<Value>) {
+      size_t seed = boost::hash<IntegerType>{}(m_pair.first);
+      boost::hash_combine(seed, Value::hash(m_pair.second));
+      return seed;
+    } else {
+      return 0;
+    }
+  }
+
+  bool shallow_equals(const PatriciaTreeLeafBase& other) const {
+    return m_pair.first == other.m_pair.first &&
+           Value::equals(m_pair.second, other.m_pair.second);
+  }
 
  protected:
   PatriciaTreeLeafBase(IntegerType key, ValueType value)
@@ -227,8 +414,9 @@ class PatriciaTreeLeafBase {
   StorageType m_pair;
 };
 
-template <typename IntegerType>
-class PatriciaTreeLeafBase<IntegerType, EmptyValue> : private EmptyValue {
+template <typename IntegerType, typename Value>
+class PatriciaTreeLeafBase<IntegerType, Value, /* IsEmpty */ true>
+    : private EmptyValue {
  public:
   using ValueType = EmptyValue;
   using StorageType = IntegerType;
@@ -241,6 +429,10 @@ class PatriciaTreeLeafBase<IntegerType, EmptyValue> : private EmptyValue {
 
   size_t hash() const { return boost::hash<IntegerType>{}(m_key); }
 
+  bool shallow_equals(const PatriciaTreeLeafBase& other) const {
+    return m_key == other.m_key;
+  }
+
  protected:
   PatriciaTreeLeafBase(IntegerType key, ValueType) : m_key(key) {}
 
@@ -267,8 +459,11 @@ class PatriciaTreeLeaf final : public PatriciaTreeNode<IntegerType, Value>,
 
   static inline boost::intrusive_ptr<PatriciaTreeLeaf> make(IntegerType key,
                                                             ValueType value) {
-    return boost::intrusive_ptr<PatriciaTreeLeaf>(
-        new PatriciaTreeLeaf(key, std::move(value)), /* add_ref */ false);
+    auto* leaf = new PatriciaTreeLeaf(key, std::move(value));
+    if constexpr (is_hash_consed_v<Value>) {
+      leaf = PatriciaTreeNodeTable<PatriciaTreeLeaf>::get().intern(leaf);
+    }
+    return boost::intrusive_ptr<PatriciaTreeLeaf>(leaf, /* add_ref */ false);
   }
 };
 
@@ -314,14 +509,17 @@ class PatriciaTreeBranchBase</* HasHash */ false> {
 };
 
 /*
- * A branch node, optionally storing a hash.
+ * A branch node, optionally storing a hash. Sets and hash-consed trees store
+ * the hash.
  */
 template <typename IntegerType, typename Value>
 class PatriciaTreeBranch final
     : public PatriciaTreeNode<IntegerType, Value>,
-      public PatriciaTreeBranchBase<std::is_same_v<Value, EmptyValue>> {
+      public PatriciaTreeBranchBase<is_empty_value_v<Value> ||
+                                    is_hash_consed_v<Value>> {
   using Base = PatriciaTreeNode<IntegerType, Value>;
-  using BranchBase = PatriciaTreeBranchBase<std::is_same_v<Value, EmptyValue>>;
+  using BranchBase = PatriciaTreeBranchBase<is_empty_value_v<Value> ||
+                                            is_hash_consed_v<Value>>;
 
  public:
   PatriciaTreeBranch(IntegerType prefix,
@@ -345,15 +543,25 @@ class PatriciaTreeBranch final
 
   const boost::intrusive_ptr<Base>& right_tree() const { return m_right_tree; }
 
+  bool shallow_equals(const PatriciaTreeBranch& other) const {
+    return m_prefix == other.m_prefix &&
+           m_branching_bit == other.m_branching_bit &&
+           m_left_tree == other.m_left_tree &&
+           m_right_tree == other.m_right_tree;
+  }
+
   static inline boost::intrusive_ptr<PatriciaTreeBranch> make(
       IntegerType prefix,
       IntegerType branching_bit,
       boost::intrusive_ptr<Base> left_tree,
       boost::intrusive_ptr<Base> right_tree) {
-    return boost::intrusive_ptr<PatriciaTreeBranch>(
-        new PatriciaTreeBranch(
-            prefix, branching_bit, std::move(left_tree), std::move(right_tree)),
-        /* add_ref */ false);
+    auto* branch = new PatriciaTreeBranch(
+        prefix, branching_bit, std::move(left_tree), std::move(right_tree));
+    if constexpr (is_hash_consed_v<Value>) {
+      branch = PatriciaTreeNodeTable<PatriciaTreeBranch>::get().intern(branch);
+    }
+    return boost::intrusive_ptr<PatriciaTreeBranch>(branch,
+                                                    /* add_ref */ false);
   }
 
  private:
@@ -700,6 +908,10 @@ inline bool is_tree_equal(
   } else if (tree1 == nullptr || tree2 == nullptr) {
     return false;
   }
+  if constexpr (is_hash_consed_v<Value>) {
+    // Structurally equal hash-consed trees are physically equal.
+    return false;
+  }
   const auto* leaf1 = tree1->as_leaf();
   const auto* leaf2 = tree2->as_leaf();
   if (leaf1 && leaf2) {
@@ -68,6 +68,12 @@ class PatriciaTreeMapStaticAssert;
  *
  *     // Whether the default value is top, bottom, or an arbitrary value.
  *     constexpr static AbstractValueKind default_value_kind;
+ *
+ *     // Optional. Intern all the nodes of the map, so that equal maps always
+ *     // share the same representation. This requires a hash function
+ *     // consistent with `equals` (see PatriciaTreeCore.h).
+ *     constexpr static bool hash_consed = true;
+ *     static size_t hash(const type& x);
  *   }
  *
  * Patricia trees can only handle unsigned integers. Arbitrary objects can be
@@ -47,10 +47,16 @@ namespace sparta {
  * accommodated as long as they are represented as pointers. Our implementation
  * of Patricia-tree sets can transparently operate on either unsigned integers
  * or pointers to objects.
+ *
+ * Using `pt_core::HashConsedEmptyValue` as the second template argument makes
+ * the hash-consing perfect: every node is interned in a global node table, so
+ * that equal sets always share the same representation (see
+ * PatriciaTreeCore.h).
  */
-template <typename Element>
-class PatriciaTreeSet final : public AbstractSet<PatriciaTreeSet<Element>> {
-  using Empty = pt_core::EmptyValue;
+template <typename Element, typename Empty = pt_core::EmptyValue>
+class PatriciaTreeSet final
+    : public AbstractSet<PatriciaTreeSet<Element, Empty>> {
+  using EmptyType = typename Empty::type;
   using Core = pt_core::PatriciaTreeCore<Element, Empty>;
   using Codec = typename Core::Codec;
 
@@ -126,7 +132,7 @@ class PatriciaTreeSet final : public AbstractSet<PatriciaTreeSet<Element>> {
   }
 
   PatriciaTreeSet& insert(Element key) {
-    m_core.upsert(key, Empty{});
+    m_core.upsert(key, EmptyType{});
     return *this;
   }
 
@@ -143,7 +149,8 @@ class PatriciaTreeSet final : public AbstractSet<PatriciaTreeSet<Element>> {
 
   template <typename Predicate> // bool(const Element&)
   PatriciaTreeSet& filter(Predicate&& predicate) {
-    m_core.filter([&](Element key, const Empty&) { return predicate(key); });
+    m_core.filter(
+        [&](Element key, const EmptyType&) { return predicate(key); });
     return *this;
   }
 
@@ -203,4 +210,8 @@ class PatriciaTreeSet final : public AbstractSet<PatriciaTreeSet<Element>> {
   Core m_core;
 };
 
+template <typename Element>
+using HashConsedPatriciaTreeSet =
+    PatriciaTreeSet<Element, pt_core::HashConsedEmptyValue>;
+
 } // namespace sparta
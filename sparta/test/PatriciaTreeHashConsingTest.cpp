@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <sparta/PatriciaTreeMap.h>
+#include <sparta/PatriciaTreeSet.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace sparta;
+
+namespace {
+
+struct HashConsedValue final : public AbstractMapValue<HashConsedValue> {
+  using type = uint32_t;
+
+  static type default_value() { return 0; }
+
+  static bool is_default_value(const type& x) { return x == 0; }
+
+  static bool equals(const type& x, const type& y) { return x == y; }
+
+  constexpr static AbstractValueKind default_value_kind =
+      AbstractValueKind::Value;
+
+  constexpr static bool hash_consed = true;
+
+  static size_t hash(const type& x) { return x; }
+};
+
+using hc_map = PatriciaTreeMap<uint32_t, uint32_t, HashConsedValue>;
+using hc_set = HashConsedPatriciaTreeSet<uint32_t>;
+
+using LeafTable = pt_core::PatriciaTreeNodeTable<
+    pt_core::PatriciaTreeLeaf<uint32_t, pt_core::HashConsedEmptyValue>>;
+using BranchTable = pt_core::PatriciaTreeNodeTable<
+    pt_core::PatriciaTreeBranch<uint32_t, pt_core::HashConsedEmptyValue>>;
+
+} // namespace
+
+TEST(PatriciaTreeHashConsingTest, setsShareRepresentation) {
+  hc_set s1;
+  for (uint32_t i = 0; i < 100; ++i) {
+    s1.insert(i * 7);
+  }
+  hc_set s2;
+  for (uint32_t i = 100; i > 0; --i) {
+    s2.insert((i - 1) * 7);
+  }
+  EXPECT_TRUE(s1.reference_equals(s2));
+  EXPECT_TRUE(s1.equals(s2));
+  EXPECT_EQ(s1.hash(), s2.hash());
+
+  s2.remove(7);
+  EXPECT_FALSE(s1.equals(s2));
+  s2.insert(7);
+  EXPECT_TRUE(s1.reference_equals(s2));
+
+  hc_set s3 = s1;
+  s3.union_with(hc_set{1000});
+  s3.intersection_with(s1);
+  EXPECT_TRUE(s3.reference_equals(s1));
+  EXPECT_TRUE(s3.is_subset_of(s1));
+}
+
+TEST(PatriciaTreeHashConsingTest, mapsShareRepresentation) {
+  hc_map m1;
+  hc_map m2;
+  for (uint32_t i = 0; i < 50; ++i) {
+    m1.insert_or_assign(i, i + 1);
+  }
+  for (uint32_t i = 50; i > 0; --i) {
+    m2.insert_or_assign(i - 1, i + 1);
+  }
+  EXPECT_FALSE(m1.equals(m2));
+
+  m2.transform([](uint32_t value) { return value - 1; });
+  EXPECT_TRUE(m1.reference_equals(m2));
+  EXPECT_TRUE(m1.equals(m2));
+}
+
+TEST(PatriciaTreeHashConsingTest, releasedNodesLeaveTheTable) {
+  size_t leafs = LeafTable::get().size();
+  size_t branches = BranchTable::get().size();
+  {
+    hc_set s;
+    for (uint32_t i = 0; i < 64; ++i) {
+      s.insert(0x10000 + i);
+    }
+    EXPECT_EQ(LeafTable::get().size(), leafs + 64);
+    EXPECT_EQ(BranchTable::get().size(), branches + 63);
+  }
+  EXPECT_EQ(LeafTable::get().size(), leafs);
+  EXPECT_EQ(BranchTable::get().size(), branches);
+}
+
+TEST(PatriciaTreeHashConsingTest, concurrentConstruction) {
+  constexpr size_t kNumThreads = 8;
+  std::vector<hc_set> sets(kNumThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&sets, t]() {
+      for (uint32_t round = 0; round < 20; ++round) {
+        hc_set s;
+        for (uint32_t i = 0; i < 200; ++i) {
+          s.insert((i * 31 + t) % 200);
+        }
+        sets[t] = std::move(s);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t t = 1; t < kNumThreads; ++t) {
+    EXPECT_TRUE(sets[0].reference_equals(sets[t]));
+  }
+  EXPECT_EQ(sets[0].size(), 200);
+}
@@ -278,3 +278,43 @@ TEST_F(CallGraphTest, test_multiple_callee_graph_invoke_super) {
   EXPECT_THAT(callees,
               ::testing::UnorderedElementsAre(more_than_5_class_return_num));
 }
+
+TEST_F(CallGraphTest, test_multiple_callee_graph_callers) {
+  const auto& graph = *multiple_graph;
+  std::vector<call_graph::NodeId> nodes(graph.num_nodes(), nullptr);
+  std::vector<const call_graph::Edge*> edges;
+  auto visit = [&](call_graph::NodeId node) {
+    ASSERT_LT(node->id(), nodes.size());
+    if (nodes[node->id()] != nullptr) {
+      EXPECT_EQ(nodes[node->id()], node);
+      return;
+    }
+    nodes[node->id()] = node;
+    for (const auto* edge : node->callees()) {
+      edges.push_back(edge);
+    }
+  };
+  visit(graph.entry());
+  visit(graph.exit());
+  EXPECT_EQ(graph.entry()->id(), 0);
+  EXPECT_EQ(graph.exit()->id(), 1);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    visit(edges[i]->callee());
+  }
+  EXPECT_THAT(nodes, ::testing::Not(::testing::Contains(nullptr)));
+
+  // Each edge is among the callers of its callee, which are sorted by caller.
+  size_t num_callers = 0;
+  for (auto node : nodes) {
+    auto callers = node->callers();
+    num_callers += callers.size();
+    for (const auto* edge : callers) {
+      EXPECT_EQ(edge->callee(), node);
+    }
+    for (size_t i = 1; i < callers.size(); ++i) {
+      EXPECT_FALSE(compare_dexmethods(callers[i]->caller()->method(),
+                                      callers[i - 1]->caller()->method()));
+    }
+  }
+  EXPECT_EQ(num_callers, edges.size());
+}
@@ -116,6 +116,17 @@ TEST_F(MethodOverrideGraphTest, verify) {
     EXPECT_EQ(node.parents.size(), parents.size());
   }
 
+  // Node ids are dense and unique.
+  std::vector<uint32_t> ids;
+  for (auto&& [method, node] : UnorderedIterable(graph->nodes())) {
+    ids.push_back(node.id);
+  }
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(ids.size(), graph->num_nodes());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(ids[i], i + 1);
+  }
+
   // The default graph build is miranda-free.
   EXPECT_FALSE(graph->has_miranda());
 }
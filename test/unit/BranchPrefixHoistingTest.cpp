@@ -172,6 +172,70 @@ TEST_F(BranchPrefixHoistingTest, hoisted_prefix_falls_back_to_a_single_copy) {
   EXPECT_EQ(sbs.size(), 1u);
 }
 
+// A type inference handed over from an earlier step describes the cfg before
+// any hoisting. Here the aput is hoisted before the const it uses is first
+// queried, so the constant uses must have been built before that hoisting.
+TEST_F(BranchPrefixHoistingTest, handed_over_type_inference) {
+  DexType* type = DexType::make_type("LHoistTI;");
+  auto* cls = create_class(type, type::java_lang_Object(), {}, ACC_PUBLIC);
+  auto* args = DexTypeList::make_type_list({type::_int()});
+  auto* proto = DexProto::make_proto(type::_void(), args);
+  auto* method =
+      DexMethod::make_method(type, DexString::make_string("test"), proto)
+          ->make_concrete(ACC_PUBLIC | ACC_STATIC, false);
+  cls->add_method(method);
+  method->set_code(assembler::ircode_from_string(R"(
+    (
+      (load-param v0)
+      (const v2 0)
+      (const v4 1)
+      (new-array v4 "[I")
+      (move-result-pseudo-object v3)
+      (if-eqz v0 :a)
+
+      (const v1 5)
+      (goto :join)
+
+      (:a)
+      (const v1 5)
+
+      (:join)
+      (if-nez v0 :b)
+
+      (aput v1 v3 v2)
+      (sput v0 "LHoistTI;.f:I")
+      (return-void)
+
+      (:b)
+      (aput v1 v3 v2)
+      (sput v4 "LHoistTI;.f:I")
+      (return-void)
+    )
+  )"));
+  auto* code = method->get_code();
+  code->build_cfg();
+  auto& cfg = code->cfg();
+
+  auto inference = std::make_unique<type_inference::TypeInference>(cfg);
+  inference->run(method);
+  size_t hoisted = 0;
+  EXPECT_NO_THROW(hoisted = branch_prefix_hoisting_impl::process_cfg(
+                      cfg, /* is_static */ true, type, proto,
+                      [&] { return show(method); }, std::move(inference)));
+  // The aput of the inner branch, then the const of the outer one.
+  EXPECT_EQ(hoisted, 2u);
+
+  size_t aputs = 0;
+  size_t fives = 0;
+  for (const auto& mie : cfg::InstructionIterable(cfg)) {
+    aputs += mie.insn->opcode() == OPCODE_APUT;
+    fives += mie.insn->opcode() == OPCODE_CONST &&
+             mie.insn->get_literal() == 5;
+  }
+  EXPECT_EQ(aputs, 1u);
+  EXPECT_EQ(fives, 1u);
+}
+
 TEST_F(BranchPrefixHoistingTest, simple_insn_hoisting) {
   const auto& code_str = R"(
     (
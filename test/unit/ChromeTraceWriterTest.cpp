@@ -83,3 +83,88 @@ TEST(ChromeTraceWriterTest, WriteProducesValidJson) {
 
   std::remove(path.c_str());
 }
+
+TEST(ChromeTraceWriterTest, CountersAndSubMicrosecondTimestamps) {
+  ChromeTraceWriter::init();
+
+  auto start = ChromeTraceWriter::clock::now();
+  ChromeTraceWriter::record("ShortEvent", start,
+                            start + std::chrono::nanoseconds(1500),
+                            std::this_thread::get_id());
+  ChromeTraceWriter::record_counter("VmRSS", 4096, start);
+
+  std::string path = make_temp_file();
+  ChromeTraceWriter::write(path);
+
+  Json::Value root = read_json_file(path);
+  ASSERT_TRUE(root.isArray());
+  const Json::Value* event = nullptr;
+  const Json::Value* counter = nullptr;
+  for (const auto& e : root) {
+    if (e["name"].asString() == "ShortEvent") {
+      event = &e;
+    } else if (e["name"].asString() == "VmRSS") {
+      counter = &e;
+    }
+  }
+  ASSERT_NE(nullptr, event);
+  EXPECT_DOUBLE_EQ(1.5, (*event)["dur"].asDouble());
+
+  ASSERT_NE(nullptr, counter);
+  EXPECT_EQ("C", (*counter)["ph"].asString());
+  EXPECT_EQ(4096u, (*counter)["args"]["value"].asUInt64());
+
+  std::remove(path.c_str());
+}
+
+TEST(ChromeTraceWriterTest, MergesEventsFromAllThreads) {
+  ChromeTraceWriter::init();
+
+  auto start = ChromeTraceWriter::clock::now();
+  std::thread other([&]() {
+    ChromeTraceWriter::record("OtherThread",
+                              start + std::chrono::microseconds(10),
+                              start + std::chrono::microseconds(20),
+                              std::this_thread::get_id());
+  });
+  other.join();
+  ChromeTraceWriter::record("MainThread", start,
+                            start + std::chrono::microseconds(30),
+                            std::this_thread::get_id());
+
+  std::string path = make_temp_file();
+  ChromeTraceWriter::write(path);
+
+  Json::Value root = read_json_file(path);
+  ASSERT_TRUE(root.isArray());
+  Json::ArrayIndex main_index = root.size();
+  Json::ArrayIndex other_index = root.size();
+  for (Json::ArrayIndex i = 0; i < root.size(); ++i) {
+    if (root[i]["name"].asString() == "MainThread") {
+      main_index = i;
+    } else if (root[i]["name"].asString() == "OtherThread") {
+      other_index = i;
+    }
+  }
+  ASSERT_LT(main_index, root.size());
+  ASSERT_LT(other_index, root.size());
+  // Events are ordered by start time, regardless of the recording thread.
+  EXPECT_LT(main_index, other_index);
+  const auto& e1 = root[main_index];
+  const auto& e2 = root[other_index];
+  EXPECT_NE(e1["tid"].asUInt64(), e2["tid"].asUInt64());
+
+  std::remove(path.c_str());
+}
+
+TEST(ChromeTraceWriterTest, WorkItemThresholdOnlyWhenEnabled) {
+  ChromeTraceWriter::init();
+  ChromeTraceWriter::set_work_item_threshold(std::chrono::microseconds(5));
+  EXPECT_EQ(std::chrono::nanoseconds(5000),
+            ChromeTraceWriter::work_item_threshold());
+
+  ChromeTraceWriter::disable();
+  EXPECT_EQ(std::chrono::nanoseconds(0),
+            ChromeTraceWriter::work_item_threshold());
+  ChromeTraceWriter::set_work_item_threshold(std::chrono::nanoseconds(0));
+}
@@ -12,6 +12,7 @@
 #include "ControlFlow.h"
 #include "Debug.h"
 #include "DexAsm.h"
+#include "Dominators.h"
 #include "IRAssembler.h"
 #include "IRCode.h"
 #include "RedexTest.h"
@@ -2927,6 +2928,46 @@ TEST_F(ControlFlowTest, insert_block_switch) {
   EXPECT_TRUE(nb0->goes_to() != nullptr && nb0->goes_to() == branch_block);
 }
 
+TEST_F(ControlFlowTest, cachedDominatorsFollowEdgeChanges) {
+  auto code = assembler::ircode_from_string(R"(
+    (
+     (load-param v0)
+     (switch v0 (:b :c))
+
+     (const v1 100)
+     (return v1)
+
+     (:b 1)
+     (:c 2)
+     (const v1 300)
+     (return v1)
+    )
+  )");
+
+  code->build_cfg();
+  auto& cfg = code->cfg();
+  auto* switch_block = cfg.entry_block();
+  auto* branch_block =
+      cfg.get_succ_edges_of_type(switch_block, cfg::EDGE_BRANCH)[0]->target();
+
+  const auto* doms = &cfg.get_dominators();
+  EXPECT_EQ(doms->get_idom(branch_block), switch_block);
+  // Queries on an unchanged CFG share the same result.
+  EXPECT_EQ(&cfg.get_dominators(), doms);
+
+  auto version = cfg.structure_version();
+  auto* nb0 = cfg.create_block();
+  cfg.insert_block(switch_block, branch_block, nb0);
+  EXPECT_NE(cfg.structure_version(), version);
+  EXPECT_EQ(cfg.get_dominators().get_idom(branch_block), nb0);
+  EXPECT_EQ(cfg.get_dominators().get_idom(nb0), switch_block);
+
+  cfg.calculate_exit_block();
+  const auto& post_doms = cfg.get_post_dominators();
+  EXPECT_EQ(post_doms.get_idom(nb0), branch_block);
+  EXPECT_EQ(&cfg.get_post_dominators(), &post_doms);
+}
+
 TEST_F(ControlFlowTest, blockUnconditionallyThrowsDirectThrow) {
   auto code = assembler::ircode_from_string(R"(
     (
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ControlFlow.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "MethodFacts.h"
+#include "RedexTest.h"
+
+class MethodFactsTest : public RedexTest {};
+
+namespace {
+
+DexMethod* make_method() {
+  return assembler::method_from_string(R"(
+    (method (public static) "LFoo;.bar:(Ljava/lang/Object;)V"
+      (
+        (load-param-object v0)
+        (monitor-enter v0)
+        (.try_start a)
+        (sget-object "LFoo;.f:Ljava/lang/Object;")
+        (move-result-pseudo-object v1)
+        (invoke-static (v1) "LFoo;.baz:(Ljava/lang/Object;)V")
+        (.try_end a)
+        (monitor-exit v0)
+        (return-void)
+        (.catch (a))
+        (move-exception v2)
+        (monitor-exit v0)
+        (throw v2)
+      )
+    )
+  )");
+}
+
+} // namespace
+
+TEST_F(MethodFactsTest, factsWithoutCfg) {
+  auto* method = make_method();
+  MethodFacts facts(method);
+  EXPECT_EQ(facts.instructions, method->get_code()->count_opcodes());
+  EXPECT_EQ(facts.code_units, method->get_code()->estimate_code_units());
+  EXPECT_EQ(facts.monitor_enters, 1);
+  EXPECT_TRUE(facts.has_catches);
+  EXPECT_TRUE(facts.has_throws);
+  ASSERT_EQ(facts.invoked_methods.size(), 1);
+  EXPECT_EQ(facts.invoked_methods[0],
+            DexMethod::get_method("LFoo;.baz:(Ljava/lang/Object;)V"));
+  ASSERT_EQ(facts.field_refs.size(), 1);
+  EXPECT_EQ(facts.field_refs[0],
+            DexField::get_field("LFoo;.f:Ljava/lang/Object;"));
+}
+
+TEST_F(MethodFactsTest, factsWithCfgMatchFactsWithoutCfg) {
+  auto* method = make_method();
+  MethodFacts before(method);
+  method->get_code()->build_cfg();
+  EXPECT_EQ(MethodFacts(method), before);
+}
+
+TEST_F(MethodFactsTest, cacheComputesMethodsOutsideTheScope) {
+  auto* method = make_method();
+  method->get_code()->build_cfg();
+  MethodFactsCache cache(Scope{});
+  EXPECT_EQ(cache.get(method), MethodFacts(method));
+  EXPECT_EQ(&cache.get(method), &cache.get(method));
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "PointsToSolver.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "IRAssembler.h"
+#include "RedexTest.h"
+#include "ScopeHelper.h"
+
+namespace {
+
+class PointsToSolverTest : public RedexTest {
+ protected:
+  void SetUp() override {
+    m_scope = create_empty_scope();
+    m_scope.push_back(assembler::class_from_string(R"(
+      (class (public) "LBase;"
+        (field (public) "LBase;.next:LBase;")
+        (method (public) "LBase;.f:()LBase;"
+          (
+            (new-instance "LBase;")
+            (move-result-pseudo-object v0)
+            (return-object v0)
+          )
+        )
+      )
+    )"));
+    m_scope.push_back(assembler::class_from_string(R"(
+      (class (public) "LDerived;" extends "LBase;"
+        (method (public) "LDerived;.f:()LBase;"
+          (
+            (new-instance "LDerived;")
+            (move-result-pseudo-object v0)
+            (return-object v0)
+          )
+        )
+      )
+    )"));
+    m_scope.push_back(assembler::class_from_string(R"(
+      (class (public) "LMain;"
+        (method (public static) "LMain;.call:()LBase;"
+          (
+            (new-instance "LDerived;")
+            (move-result-pseudo-object v0)
+            (invoke-virtual (v0) "LBase;.f:()LBase;")
+            (move-result-object v1)
+            (return-object v1)
+          )
+        )
+        (method (public static) "LMain;.field:()LBase;"
+          (
+            (new-instance "LBase;")
+            (move-result-pseudo-object v0)
+            (new-instance "LDerived;")
+            (move-result-pseudo-object v1)
+            (iput-object v1 v0 "LBase;.next:LBase;")
+            (iget-object v0 "LBase;.next:LBase;")
+            (move-result-pseudo-object v2)
+            (return-object v2)
+          )
+        )
+      )
+    )"));
+    for (auto* cls : m_scope) {
+      for (auto* method : cls->get_all_methods()) {
+        if (method->get_code() != nullptr) {
+          method->get_code()->build_cfg();
+        }
+      }
+    }
+    m_semantics = std::make_unique<PointsToSemantics>(m_scope);
+  }
+
+  const PointsToAction* find_action(const char* method,
+                                    PointsToOperationKind kind) {
+    auto semantics = m_semantics->get_method_semantics(
+        DexMethod::get_method(method));
+    always_assert(semantics);
+    for (const auto& action : (*semantics)->get_points_to_actions()) {
+      if (action.operation().kind == kind) {
+        return &action;
+      }
+    }
+    return nullptr;
+  }
+
+  Scope m_scope;
+  std::unique_ptr<PointsToSemantics> m_semantics;
+};
+
+} // namespace
+
+TEST_F(PointsToSolverTest, virtualCallsFollowReceiverTypes) {
+  PointsToSolver solver(*m_semantics);
+  solver.solve();
+
+  auto* call = DexMethod::get_method("LMain;.call:()LBase;");
+  const auto* invoke = find_action("LMain;.call:()LBase;", PTS_INVOKE_VIRTUAL);
+  ASSERT_NE(invoke, nullptr);
+  EXPECT_THAT(solver.get_call_targets(invoke),
+              ::testing::ElementsAre(
+                  DexMethod::get_method("LDerived;.f:()LBase;")->as_def()));
+
+  const auto* ret = find_action("LMain;.call:()LBase;", PTS_RETURN);
+  ASSERT_NE(ret, nullptr);
+  auto points_to = solver.get_points_to(call, ret->src());
+  ASSERT_EQ(points_to.size(), 1);
+  const auto& object = solver.get_object(*points_to.begin());
+  EXPECT_EQ(object.kind, PointsToAbstractObject::ALLOCATION);
+  EXPECT_EQ(object.type, DexType::get_type("LDerived;"));
+  EXPECT_EQ(object.method, DexMethod::get_method("LDerived;.f:()LBase;"));
+  EXPECT_TRUE(solver.may_alias(call, ret->src(), call, invoke->dest()));
+}
+
+TEST_F(PointsToSolverTest, fieldsAreSensitiveToTheirBase) {
+  PointsToSolver solver(*m_semantics);
+  solver.solve();
+
+  auto* field = DexMethod::get_method("LMain;.field:()LBase;");
+  const auto* ret = find_action("LMain;.field:()LBase;", PTS_RETURN);
+  ASSERT_NE(ret, nullptr);
+  auto points_to = solver.get_points_to(field, ret->src());
+  ASSERT_EQ(points_to.size(), 1);
+  const auto& object = solver.get_object(*points_to.begin());
+  EXPECT_EQ(object.type, DexType::get_type("LDerived;"));
+  EXPECT_EQ(object.method, field);
+
+  const auto* put = find_action("LMain;.field:()LBase;", PTS_IPUT);
+  ASSERT_NE(put, nullptr);
+  EXPECT_FALSE(solver.may_alias(field, put->lhs(), field, ret->src()));
+}
+
+TEST_F(PointsToSolverTest, exceptionCallsReachAllOverrides) {
+  m_scope.push_back(assembler::class_from_string(R"(
+    (class (public) "LMyException;" extends "Ljava/lang/Throwable;"
+      (method (public) "LMyException;.getMessage:()Ljava/lang/String;"
+        (
+          (const-string "mine")
+          (move-result-pseudo-object v0)
+          (return-object v0)
+        )
+      )
+    )
+  )"));
+  m_scope.push_back(assembler::class_from_string(R"(
+    (class (public) "LOtherException;" extends "Ljava/lang/Throwable;"
+      (method (public) "LOtherException;.getMessage:()Ljava/lang/String;"
+        (
+          (const-string "other")
+          (move-result-pseudo-object v0)
+          (return-object v0)
+        )
+      )
+    )
+  )"));
+  m_scope.push_back(assembler::class_from_string(R"(
+    (class (public) "LThrower;"
+      (method (public static) "LThrower;.message:()Ljava/lang/String;"
+        (
+          (new-instance "LMyException;")
+          (move-result-pseudo-object v0)
+          (invoke-virtual (v0) "Ljava/lang/Throwable;.getMessage:()Ljava/lang/String;")
+          (move-result-object v1)
+          (return-object v1)
+        )
+      )
+    )
+  )"));
+  for (auto* cls : m_scope) {
+    for (auto* method : cls->get_all_methods()) {
+      if (method->get_code() != nullptr && !method->get_code()->cfg_built()) {
+        method->get_code()->build_cfg();
+      }
+    }
+  }
+  m_semantics = std::make_unique<PointsToSemantics>(m_scope);
+  PointsToSolver solver(*m_semantics);
+  solver.solve();
+
+  // All exceptions are a single abstract object, so the call may reach the
+  // override of any subclass of java.lang.Throwable.
+  const auto* invoke =
+      find_action("LThrower;.message:()Ljava/lang/String;", PTS_INVOKE_VIRTUAL);
+  ASSERT_NE(invoke, nullptr);
+  EXPECT_THAT(
+      solver.get_call_targets(invoke),
+      ::testing::ElementsAre(
+          DexMethod::get_method("LMyException;.getMessage:()Ljava/lang/String;")
+              ->as_def(),
+          DexMethod::get_method(
+              "LOtherException;.getMessage:()Ljava/lang/String;")
+              ->as_def()));
+
+  auto* message =
+      DexMethod::get_method("LThrower;.message:()Ljava/lang/String;");
+  const auto* ret =
+      find_action("LThrower;.message:()Ljava/lang/String;", PTS_RETURN);
+  ASSERT_NE(ret, nullptr);
+  EXPECT_EQ(solver.get_points_to(message, ret->src()).size(), 2);
+}
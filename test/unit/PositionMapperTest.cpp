@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "DexClass.h"
+#include "DexPosition.h"
+#include "PositionMap.h"
+#include "RedexContext.h"
+#include "RedexTest.h"
+
+class PositionMapperTest : public RedexTest {};
+
+TEST_F(PositionMapperTest, CopiesOfPositionsShareLines) {
+  const auto* file = DexString::make_string("Foo.java");
+  const auto* caller = DexString::make_string("LFoo;.caller:()V");
+  const auto* callee = DexString::make_string("LFoo;.callee:()V");
+
+  // Two inlined copies of the same callee position, each with its own copy of
+  // the callsite position.
+  DexPosition callsite1(caller, file, 10);
+  DexPosition callsite2(caller, file, 10);
+  DexPosition inlined1(callee, file, 20);
+  inlined1.parent = &callsite1;
+  DexPosition inlined2(callee, file, 20);
+  inlined2.parent = &callsite2;
+  DexPosition other(callee, file, 21);
+  other.parent = &callsite1;
+
+  RealPositionMapper mapper("");
+  auto inlined1_line = mapper.position_to_line(&inlined1);
+  auto inlined2_line = mapper.position_to_line(&inlined2);
+  auto other_line = mapper.position_to_line(&other);
+  auto callsite1_line = mapper.position_to_line(&callsite1);
+  auto callsite2_line = mapper.position_to_line(&callsite2);
+
+  EXPECT_EQ(inlined1_line, inlined2_line);
+  EXPECT_NE(inlined1_line, other_line);
+  EXPECT_EQ(callsite1_line, callsite2_line);
+  EXPECT_NE(inlined1_line, callsite1_line);
+  EXPECT_EQ(3u, mapper.size());
+}
+
+TEST_F(PositionMapperTest, SwitchesWithEqualCasesKeepTheirOwnEntries) {
+  const auto* file = DexString::make_string("Foo.java");
+  const auto* method = DexString::make_string("LFoo;.bar:()V");
+  DexPosition pos_x(method, file, 10);
+  DexPosition pos_y(method, file, 20);
+  DexPosition pos_z(method, file, 30);
+
+  // Two switches with the same number of cases, which also share a case.
+  auto* manager = g_redex->get_position_pattern_switch_manager();
+  auto pattern0 = manager->make_pattern({&pos_x});
+  auto pattern1 = manager->make_pattern({&pos_y});
+  auto switch_a = manager->make_switch({{pattern0, &pos_x}, {pattern1, &pos_y}});
+  auto switch_b = manager->make_switch({{pattern0, &pos_x}, {pattern1, &pos_z}});
+  auto pattern0_pos = manager->make_pattern_position(pattern0);
+  auto pattern1_pos = manager->make_pattern_position(pattern1);
+  auto switch_a_pos = manager->make_switch_position(switch_a);
+  auto switch_b_pos = manager->make_switch_position(switch_b);
+
+  auto tmp_dir = redex::make_tmp_dir("redex_position_mapper_test_%%%%%%%%");
+  auto map_filename = tmp_dir.path + "/line_map";
+  RealPositionMapper mapper(map_filename);
+  for (auto* pos : {pattern0_pos.get(), pattern1_pos.get(), switch_a_pos.get(),
+                    switch_b_pos.get()}) {
+    mapper.position_to_line(pos);
+  }
+  mapper.write_map();
+
+  auto map = MappedPositionMap::open(map_filename.c_str());
+  ASSERT_NE(map, nullptr);
+  auto expect_switch = [&](const DexPosition* switch_pos,
+                           const std::vector<uint32_t>& case_lines) {
+    // The switch position now refers to the count entry, which is followed by
+    // one entry per case.
+    size_t idx = switch_pos->line;
+    ASSERT_LT(idx + case_lines.size(), map->size());
+    const auto& count = map->position(idx);
+    EXPECT_EQ(map->string(count.method_id), "count");
+    EXPECT_EQ(count.line, case_lines.size());
+    for (size_t i = 0; i < case_lines.size(); ++i) {
+      const auto& c = map->position(idx + 1 + i);
+      EXPECT_EQ(map->string(c.method_id), "case");
+      EXPECT_EQ(c.line, i == 0 ? pattern0 : pattern1);
+      ASSERT_GT(c.parent, 0);
+      EXPECT_EQ(map->position(c.parent - 1).line, case_lines[i]);
+    }
+  };
+  expect_switch(switch_a_pos.get(), {10, 20});
+  expect_switch(switch_b_pos.get(), {10, 30});
+  EXPECT_NE(switch_a_pos->line, switch_b_pos->line);
+}
+
+TEST_F(PositionMapperTest, IndexedMapRoundTrips) {
+  const auto* foo_file = DexString::make_string("Foo.java");
+  const auto* bar_file = DexString::make_string("Bar.java");
+  const auto* caller = DexString::make_string("Lcom/foo/Foo;.caller:()V");
+  const auto* callee = DexString::make_string("Lcom/foo/Bar;.callee:(I)I");
+  DexPosition callsite(caller, foo_file, 10);
+  DexPosition inlined(callee, bar_file, 20);
+  inlined.parent = &callsite;
+  DexPosition other(caller, foo_file, 11);
+
+  auto tmp_dir = redex::make_tmp_dir("redex_position_mapper_test_%%%%%%%%");
+  auto map_filename = tmp_dir.path + "/line_map";
+  RealPositionMapper mapper(map_filename);
+  auto inlined_line = mapper.position_to_line(&inlined);
+  auto other_line = mapper.position_to_line(&other);
+  mapper.register_position(&callsite);
+  mapper.write_map();
+
+  auto expected = read_map(map_filename.c_str());
+  ASSERT_NE(expected, nullptr);
+  ASSERT_EQ(expected->positions_size, 3);
+  auto expect_same_stacks = [&](const MappedPositionMap& map) {
+    ASSERT_EQ(map.size(), expected->positions_size);
+    for (int64_t idx = 0; idx < (int64_t)map.size(); ++idx) {
+      auto stack = get_stack(map, idx);
+      auto expected_stack = get_stack(*expected, idx);
+      ASSERT_EQ(stack.size(), expected_stack.size());
+      for (size_t i = 0; i < stack.size(); ++i) {
+        EXPECT_EQ(stack[i].cls, expected_stack[i].cls);
+        EXPECT_EQ(stack[i].method, expected_stack[i].method);
+        EXPECT_EQ(stack[i].filename, expected_stack[i].filename);
+        EXPECT_EQ(stack[i].line, expected_stack[i].line);
+      }
+    }
+  };
+
+  auto indexed = MappedPositionMap::open(map_filename.c_str());
+  ASSERT_NE(indexed, nullptr);
+  EXPECT_TRUE(indexed->has_index());
+  expect_same_stacks(*indexed);
+  auto stack = get_stack(*indexed, inlined_line - 1);
+  ASSERT_EQ(stack.size(), 2);
+  EXPECT_EQ(stack[0].cls, "com.foo.Bar");
+  EXPECT_EQ(stack[0].method, "callee");
+  EXPECT_EQ(stack[0].filename, "Bar.java");
+  EXPECT_EQ(stack[0].line, 20);
+  EXPECT_EQ(stack[1].cls, "com.foo.Foo");
+  EXPECT_EQ(stack[1].method, "caller");
+  EXPECT_EQ(stack[1].line, 10);
+  EXPECT_EQ(get_stack(*indexed, other_line - 1).size(), 1);
+
+  // Without the index, the string pool is scanned instead.
+  boost::filesystem::remove(map_filename + ".idx");
+  auto scanned = MappedPositionMap::open(map_filename.c_str());
+  ASSERT_NE(scanned, nullptr);
+  EXPECT_FALSE(scanned->has_index());
+  expect_same_stacks(*scanned);
+}
@@ -341,3 +341,32 @@ TEST_F(ProguardMapTest, DeobfuscateFramesWithoutLineRange) {
 
   EXPECT_CODE_EQ(code.get(), expected_code.get());
 }
+
+TEST_F(ProguardMapTest, LargeMapParsedInChunks) {
+  // Large enough to be split into several chunks, which are parsed in
+  // parallel. Members must still be attributed to their class, and member
+  // types translated with classes defined in later chunks.
+  constexpr size_t kNumClasses = 40000;
+  std::stringstream ss;
+  for (size_t i = 0; i < kNumClasses; ++i) {
+    auto next = (i + 1) % kNumClasses;
+    ss << "com.foo.Class" << i << " -> X.c" << i << ":\n"
+       << "# {\"id\":\"sourceFile\",\"fileName\":\"Class" << i << ".java\"}\n"
+       << "    com.foo.Class" << next << " next -> a\n"
+       << "    1:2:com.foo.Class" << next << " getNext(int) -> b\n";
+  }
+  ProguardMap pm(ss);
+
+  for (size_t i : {size_t(0), kNumClasses / 2, kNumClasses - 1}) {
+    auto next = (i + 1) % kNumClasses;
+    auto cls = "Lcom/foo/Class" + std::to_string(i) + ";";
+    auto next_cls = "Lcom/foo/Class" + std::to_string(next) + ";";
+    auto obf = "LX/c" + std::to_string(i) + ";";
+    auto next_obf = "LX/c" + std::to_string(next) + ";";
+    EXPECT_EQ(obf, pm.translate_class(cls));
+    EXPECT_EQ(obf + ".a:" + next_obf,
+              pm.translate_field(cls + ".next:" + next_cls));
+    EXPECT_EQ(cls + ".getNext:(I)" + next_cls,
+              pm.deobfuscate_method(obf + ".b:(I)" + next_obf));
+  }
+}
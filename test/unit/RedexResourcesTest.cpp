@@ -17,6 +17,7 @@
 #include "RedexResources.h"
 #include "RedexTest.h"
 #include "ResourcesTestDefs.h"
+#include "WorkQueue.h"
 
 using std::operator""sv;
 using ::testing::UnorderedElementsAre;
@@ -751,3 +752,15 @@ TEST(RedexResources, StyleInfoGetNewResourceId) {
   EXPECT_EQ(second_id, 0x7f010002u);
   EXPECT_EQ(third_id, 0x7f010003u);
 }
+
+TEST(RedexResources, GetReadThreads) {
+  auto max_threads = redex_parallel::default_num_threads();
+  EXPECT_EQ(resources::get_read_threads(0, 64), 1);
+  EXPECT_EQ(resources::get_read_threads(1, 64), 1);
+  EXPECT_EQ(resources::get_read_threads(64, 64), 1);
+  EXPECT_EQ(resources::get_read_threads(65, 64),
+            std::min<size_t>(2, max_threads));
+  EXPECT_EQ(resources::get_read_threads(1000000, 64), max_threads);
+  EXPECT_EQ(resources::get_read_threads(3, 1),
+            std::min<size_t>(3, max_threads));
+}
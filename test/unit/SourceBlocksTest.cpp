@@ -1515,6 +1515,48 @@ TEST_F(SourceBlocksTest, source_block_appear_100_inequality) {
   ASSERT_NE(sb1, sb2);
 }
 
+TEST_F(SourceBlocksTest, source_block_shared_vals_are_copied_on_write) {
+  // Blocks with equal profile values share their storage; mutating one of
+  // them must not be observable through the others.
+  const auto* s = DexString::make_string("x");
+  std::vector<SourceBlock::Val> vals{SourceBlock::Val(1, 10),
+                                     SourceBlock::Val::default_value(),
+                                     SourceBlock::Val(3, 30)};
+  SourceBlock a(s, 0, vals);
+  SourceBlock b(s, 1, vals);
+  SourceBlock c(a);
+
+  a.set_at(0, SourceBlock::Val(5, 50));
+  EXPECT_FLOAT_EQ(*a.get_val(0), 5.0f);
+  EXPECT_FLOAT_EQ(*b.get_val(0), 1.0f);
+  EXPECT_FLOAT_EQ(*c.get_val(0), 1.0f);
+
+  b.foreach_val([](auto& val) {
+    if (val && val->val == 3) {
+      val->val = 4;
+    }
+  });
+  EXPECT_FLOAT_EQ(*b.get_val(2), 4.0f);
+  EXPECT_FLOAT_EQ(*c.get_val(2), 3.0f);
+
+  c.fill(SourceBlock::Val(7, 70));
+  EXPECT_FLOAT_EQ(*c.get_val(1), 7.0f);
+
+  SourceBlock d(s, 2, vals);
+  EXPECT_FLOAT_EQ(*d.get_val(0), 1.0f);
+  EXPECT_FLOAT_EQ(*d.get_val(1), 0.0f);
+  EXPECT_FLOAT_EQ(*d.get_val(2), 3.0f);
+
+  // Normalizing shares the values again without changing them.
+  size_t elided = 0;
+  size_t unelided = 0;
+  a.set_at(0, SourceBlock::Val(1, 10));
+  a.normalize(&elided, &unelided);
+  EXPECT_EQ(elided, 1);
+  EXPECT_EQ(unelided, 2);
+  EXPECT_EQ(SourceBlock(s, 0, vals), a);
+}
+
 TEST_F(SourceBlocksTest, dedup_block_with_source_blocks_in_instrumentation) {
 
   g_redex->instrument_mode = true;
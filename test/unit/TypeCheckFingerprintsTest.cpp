@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ControlFlow.h"
+#include "DexClass.h"
+#include "IRAssembler.h"
+#include "IRCode.h"
+#include "RedexTest.h"
+#include "TypeCheckFingerprints.h"
+#include "TypeUtil.h"
+
+class TypeCheckFingerprintsTest : public RedexTest {
+ protected:
+  void SetUp() override {
+    assembler::class_from_string(R"(
+      (class (public) "LFoo;"
+        (method (public static) "LFoo;.callee:(I)V"
+          (
+            (load-param v0)
+            (return-void)
+          )
+        )
+        (method (public static) "LFoo;.caller:()V"
+          (
+            (const v0 1)
+            (invoke-static (v0) "LFoo;.callee:(I)V")
+            (return-void)
+          )
+        )
+        (method (public static) "LFoo;.other:()V"
+          (
+            (return-void)
+          )
+        )
+      )
+    )");
+    m_callee = DexMethod::get_method("LFoo;.callee:(I)V")->as_def();
+    m_caller = DexMethod::get_method("LFoo;.caller:()V")->as_def();
+    m_other = DexMethod::get_method("LFoo;.other:()V")->as_def();
+    m_caller->get_code()->build_cfg();
+  }
+
+  // As in the type checker, every check uses a fresh instance.
+  static size_t fingerprint(DexMethod* method) {
+    return TypeCheckFingerprints().fingerprint(method);
+  }
+
+  DexMethod* m_callee;
+  DexMethod* m_caller;
+  DexMethod* m_other;
+};
+
+TEST_F(TypeCheckFingerprintsTest, unchangedMethodIsSkipped) {
+  auto before = fingerprint(m_caller);
+  EXPECT_EQ(fingerprint(m_caller), before);
+  EXPECT_NE(fingerprint(m_other), before);
+}
+
+TEST_F(TypeCheckFingerprintsTest, changedBodyIsRechecked) {
+  auto before = fingerprint(m_caller);
+  auto* insn = new IRInstruction(OPCODE_CONST);
+  insn->set_dest(1)->set_literal(2);
+  m_caller->get_code()->cfg().entry_block()->push_front(insn);
+  EXPECT_NE(fingerprint(m_caller), before);
+}
+
+TEST_F(TypeCheckFingerprintsTest, changedCalleeSignatureIsRechecked) {
+  auto caller_before = fingerprint(m_caller);
+  auto other_before = fingerprint(m_other);
+  m_callee->change(
+      DexMethodSpec(nullptr,
+                    nullptr,
+                    DexProto::make_proto(
+                        type::_void(),
+                        DexTypeList::make_type_list({type::_long()}))),
+      /* rename_on_collision */ false);
+  EXPECT_NE(fingerprint(m_caller), caller_before);
+  EXPECT_EQ(fingerprint(m_other), other_before);
+}
@@ -213,6 +213,15 @@ TEST_F(TypeSystemTest, empty) {
   EXPECT_EQ(types.size(), 0);
   types.clear();
 
+  // Children are a contiguous pre-order range, with each subtree following
+  // its root.
+  auto c_range = type_system.get_all_children(c_t);
+  EXPECT_THAT(c_range, ::testing::UnorderedElementsAre(d_t, e_t, f_t));
+  auto g_range = type_system.get_all_children(g_t);
+  EXPECT_THAT(g_range, ::testing::ElementsAre(h_t, i_t, j_t, l_t));
+  EXPECT_TRUE(type_system.get_all_children(odd11_t).empty());
+  EXPECT_TRUE(type_system.get_all_children(i1_t).empty());
+
   EXPECT_EQ(type_system.parent_chain(a_t).size(), 2);
   EXPECT_THAT(type_system.parent_chain(a_t),
               ::testing::UnorderedElementsAre(a_t, obj_t));
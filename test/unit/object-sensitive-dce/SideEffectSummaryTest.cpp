@@ -9,9 +9,11 @@
 
 #include <gtest/gtest.h>
 
+#include "Creators.h"
 #include "IRAssembler.h"
 #include "LocalPointersAnalysis.h"
 #include "RedexTest.h"
+#include "SummarySerialization.h"
 
 using namespace side_effects;
 
@@ -107,3 +109,38 @@ TEST_F(SideEffectSummaryTest, unknownWrite) {
   EXPECT_EQ(analyze_code_effects(code.get()),
             Summary(EFF_WRITE_MAY_ESCAPE, {}));
 }
+
+TEST_F(SideEffectSummaryTest, binarySerializationRoundTrip) {
+  ClassCreator cc(DexType::make_type("LExternal;"));
+  cc.set_super(type::java_lang_Object());
+  cc.set_external();
+  cc.create();
+  auto* pure = DexMethod::make_method("LExternal;.pure:()V");
+  auto* also_pure = DexMethod::make_method("LExternal;.alsoPure:()V");
+  auto* writes = DexMethod::make_method("LExternal;.writes:(LFoo;)V");
+
+  std::map<const DexMethodRef*, Summary, dexmethods_comparator> summaries;
+  summaries.emplace(pure, Summary(EFF_NONE, {}));
+  summaries.emplace(also_pure, Summary(EFF_NONE, {}));
+  summaries.emplace(writes, Summary(EFF_THROWS, {1}, true));
+
+  std::ostringstream binary;
+  summary_serialization::print_binary(binary, summaries);
+  auto data = binary.str();
+  ASSERT_TRUE(summary_serialization::is_binary(data));
+
+  UnorderedMap<const DexMethodRef*, Summary> loaded;
+  EXPECT_EQ(3u, summary_serialization::read_binary(data, &loaded));
+  EXPECT_EQ(3u, loaded.size());
+  EXPECT_EQ(Summary(EFF_NONE, {}), loaded.at(pure));
+  EXPECT_EQ(Summary(EFF_NONE, {}), loaded.at(also_pure));
+  EXPECT_EQ(Summary(EFF_THROWS, {1}, true), loaded.at(writes));
+
+  // The text format remains readable and holds the same summaries.
+  std::stringstream text;
+  summary_serialization::print(text, summaries);
+  ASSERT_FALSE(summary_serialization::is_binary(text.str()));
+  UnorderedMap<const DexMethodRef*, Summary> loaded_text;
+  EXPECT_EQ(3u, summary_serialization::read(text, &loaded_text));
+  EXPECT_EQ(loaded.at(writes), loaded_text.at(writes));
+}
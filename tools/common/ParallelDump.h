@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The number of jobs to use when none is given on the command line.
+inline size_t default_dump_jobs() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Parses the argument of a -j/--jobs option, or returns 0 if it is invalid.
+inline size_t parse_dump_jobs(const char* arg) {
+  char* end = nullptr;
+  auto jobs = strtoul(arg, &end, 10);
+  return (end == arg || *end != '\0') ? 0 : jobs;
+}
+
+// Computes the output for each of `count` inputs with `dump(i)` on up to `jobs`
+// threads, and writes it to `out` in input order. The output of an input is
+// written as soon as the outputs of all preceding inputs are, so results
+// stream while later inputs are still being processed. At most a few inputs
+// per job are buffered ahead of the one being written.
+template <typename DumpFn>
+void parallel_dump(size_t count, size_t jobs, const DumpFn& dump, FILE* out) {
+  jobs = std::min(jobs, count);
+  if (jobs <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      auto output = dump(i);
+      fwrite(output.data(), 1, output.size(), out);
+      fflush(out);
+    }
+    return;
+  }
+
+  const size_t window = 4 * jobs;
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t next = 0;
+  size_t written = 0;
+  std::vector<std::optional<std::string>> outputs(count);
+
+  auto worker = [&]() {
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return next >= count || next < written + window; });
+        if (next >= count) {
+          return;
+        }
+        i = next++;
+      }
+      auto output = dump(i);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        outputs[i] = std::move(output);
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(jobs);
+  for (size_t t = 0; t < jobs; ++t) {
+    threads.emplace_back(worker);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    std::string output;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return outputs[i].has_value(); });
+      output = std::move(*outputs[i]);
+      outputs[i].reset();
+      written = i + 1;
+    }
+    cv.notify_all();
+    fwrite(output.data(), 1, output.size(), out);
+    fflush(out);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
@@ -6,12 +6,14 @@
  */
 
 #include <boost/scope_exit.hpp>
+#include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "PositionMap.h"
 
@@ -74,7 +76,176 @@ std::vector<Position> get_stack(const PositionMap& map, int64_t idx) {
     stack.emplace_back(map.string_pool[pi.class_id],
                        map.string_pool[pi.method_id],
                        map.string_pool[pi.file_id],
-                       pi.line);
+                       (uint32_t)pi.line);
+    idx = (int64_t)pi.parent - 1;
+  }
+  return stack;
+}
+
+namespace {
+
+constexpr uint32_t MAGIC = 0xfaceb000;
+constexpr uint32_t MAP_VERSION = 2;
+constexpr uint32_t INDEX_VERSION = 1;
+// magic, version, map_size (8 bytes), string_pool_size, positions_size,
+// positions_offset.
+constexpr size_t INDEX_HEADER_SIZE = 7 * sizeof(uint32_t);
+
+uint32_t read_u32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint64_t read_u64(const uint8_t* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+const uint8_t* map_file(const char* filename, size_t* size, bool quiet) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) {
+    if (!quiet) {
+      std::cerr << "open failed for file (" << filename
+                << ") with error: " << strerror(errno) << std::endl;
+    }
+    return nullptr;
+  }
+  BOOST_SCOPE_EXIT_ALL(=) { close(fd); };
+  struct stat buf;
+  if (fstat(fd, &buf) != 0 || buf.st_size == 0) {
+    if (!quiet) {
+      std::cerr << "Cannot fstat file (" << filename
+                << ") or file is empty" << std::endl;
+    }
+    return nullptr;
+  }
+  void* mapping =
+      mmap(nullptr, buf.st_size, PROT_READ, MAP_FILE | MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    if (!quiet) {
+      std::cerr << "mmap failed for file (" << filename
+                << ") with error: " << strerror(errno) << std::endl;
+    }
+    return nullptr;
+  }
+  *size = buf.st_size;
+  return static_cast<const uint8_t*>(mapping);
+}
+
+} // namespace
+
+std::unique_ptr<MappedPositionMap> MappedPositionMap::open(
+    const char* filename) {
+  std::unique_ptr<MappedPositionMap> map(new MappedPositionMap());
+  map->m_mapping = map_file(filename, &map->m_mapping_size, /* quiet */ false);
+  if (map->m_mapping == nullptr) {
+    return nullptr;
+  }
+  if (map->m_mapping_size < 3 * sizeof(uint32_t) ||
+      read_u32(map->m_mapping) != MAGIC) {
+    std::cerr << "Magic number mismatch\n";
+    return nullptr;
+  }
+  if (read_u32(map->m_mapping + sizeof(uint32_t)) != MAP_VERSION) {
+    std::cerr << "Version mismatch\n";
+    return nullptr;
+  }
+  map->m_string_pool_size = read_u32(map->m_mapping + 2 * sizeof(uint32_t));
+  if (!map->load_index(std::string(filename) + ".idx") &&
+      !map->scan_string_pool()) {
+    std::cerr << "Truncated line map\n";
+    return nullptr;
+  }
+  return map;
+}
+
+MappedPositionMap::~MappedPositionMap() {
+  if (m_mapping != nullptr) {
+    munmap(const_cast<uint8_t*>(m_mapping), m_mapping_size);
+  }
+  if (m_index_mapping != nullptr) {
+    munmap(const_cast<uint8_t*>(m_index_mapping), m_index_mapping_size);
+  }
+}
+
+bool MappedPositionMap::load_index(const std::string& filename) {
+  size_t size = 0;
+  const uint8_t* index = map_file(filename.c_str(), &size, /* quiet */ true);
+  if (index == nullptr) {
+    return false;
+  }
+  bool valid = size >= INDEX_HEADER_SIZE && read_u32(index) == MAGIC &&
+               read_u32(index + 4) == INDEX_VERSION &&
+               read_u64(index + 8) == m_mapping_size &&
+               read_u32(index + 16) == m_string_pool_size &&
+               size == INDEX_HEADER_SIZE +
+                           sizeof(uint32_t) * uint64_t(m_string_pool_size);
+  uint32_t positions_size = valid ? read_u32(index + 20) : 0;
+  uint32_t positions_offset = valid ? read_u32(index + 24) : 0;
+  // The index must describe exactly the positions at the end of the map.
+  valid = valid && positions_offset >= 4 * sizeof(uint32_t) &&
+          positions_offset +
+                  sizeof(PositionItem) * uint64_t(positions_size) ==
+              m_mapping_size &&
+          read_u32(m_mapping + positions_offset - sizeof(uint32_t)) ==
+              positions_size;
+  if (!valid) {
+    std::cerr << "Ignoring stale line map index " << filename << std::endl;
+    munmap(const_cast<uint8_t*>(index), size);
+    return false;
+  }
+  m_index_mapping = index;
+  m_index_mapping_size = size;
+  m_string_offsets =
+      reinterpret_cast<const uint32_t*>(index + INDEX_HEADER_SIZE);
+  m_positions =
+      reinterpret_cast<const PositionItem*>(m_mapping + positions_offset);
+  m_positions_size = positions_size;
+  return true;
+}
+
+bool MappedPositionMap::scan_string_pool() {
+  uint64_t offset = 3 * sizeof(uint32_t);
+  m_scanned_string_offsets.reserve(m_string_pool_size);
+  for (uint32_t i = 0; i < m_string_pool_size; ++i) {
+    if (offset + sizeof(uint32_t) > m_mapping_size) {
+      return false;
+    }
+    m_scanned_string_offsets.push_back(static_cast<uint32_t>(offset));
+    offset += sizeof(uint32_t) + read_u32(m_mapping + offset);
+  }
+  if (offset + sizeof(uint32_t) > m_mapping_size) {
+    return false;
+  }
+  uint32_t positions_size = read_u32(m_mapping + offset);
+  offset += sizeof(uint32_t);
+  if (offset + sizeof(PositionItem) * uint64_t(positions_size) >
+      m_mapping_size) {
+    return false;
+  }
+  m_string_offsets = m_scanned_string_offsets.data();
+  m_positions = reinterpret_cast<const PositionItem*>(m_mapping + offset);
+  m_positions_size = positions_size;
+  return true;
+}
+
+std::string_view MappedPositionMap::string(uint32_t id) const {
+  const uint8_t* entry = m_mapping + m_string_offsets[id];
+  return std::string_view(reinterpret_cast<const char*>(entry) +
+                              sizeof(uint32_t),
+                          read_u32(entry));
+}
+
+std::vector<Position> get_stack(const MappedPositionMap& map, int64_t idx) {
+  std::vector<Position> stack;
+  while (idx >= 0 && (size_t)idx < map.size()) {
+    const auto& pi = map.position(idx);
+    stack.emplace_back(std::string(map.string(pi.class_id)),
+                       std::string(map.string(pi.method_id)),
+                       std::string(map.string(pi.file_id)),
+                       (uint32_t)pi.line);
     idx = (int64_t)pi.parent - 1;
   }
   return stack;
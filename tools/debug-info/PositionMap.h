@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -43,3 +45,44 @@ struct PositionMap {
 
 std::unique_ptr<PositionMap> read_map(const char* filename);
 std::vector<Position> get_stack(const PositionMap& map, int64_t idx);
+
+/*
+ * A line map used in place after mapping it into memory, so that opening it
+ * does not depend on its size. The offsets of the variable-length strings come
+ * from the index file that redex writes next to the map (the map file name
+ * followed by ".idx"); without a valid index, they are computed by walking the
+ * string pool once.
+ */
+class MappedPositionMap {
+ public:
+  static std::unique_ptr<MappedPositionMap> open(const char* filename);
+
+  MappedPositionMap(const MappedPositionMap&) = delete;
+  MappedPositionMap& operator=(const MappedPositionMap&) = delete;
+  ~MappedPositionMap();
+
+  size_t size() const { return m_positions_size; }
+  const PositionItem& position(size_t idx) const { return m_positions[idx]; }
+  std::string_view string(uint32_t id) const;
+  bool has_index() const { return m_index_mapping != nullptr; }
+
+ private:
+  MappedPositionMap() = default;
+  bool load_index(const std::string& filename);
+  bool scan_string_pool();
+
+  const uint8_t* m_mapping{nullptr};
+  size_t m_mapping_size{0};
+  const uint8_t* m_index_mapping{nullptr};
+  size_t m_index_mapping_size{0};
+
+  // The offsets of the string_length fields of the strings, either in the
+  // index mapping or in m_scanned_string_offsets.
+  const uint32_t* m_string_offsets{nullptr};
+  uint32_t m_string_pool_size{0};
+  std::vector<uint32_t> m_scanned_string_offsets;
+  const PositionItem* m_positions{nullptr};
+  size_t m_positions_size{0};
+};
+
+std::vector<Position> get_stack(const MappedPositionMap& map, int64_t idx);
@@ -6,30 +6,120 @@
  */
 
 #include <boost/regex.hpp>
+#include <cstdio>
+#include <getopt.h> // @donotremove
 #include <iostream>
 #include <string>
+#include <vector>
 
+#include "ParallelDump.h"
 #include "PositionMap.h"
 
-boost::regex trace_regex(R"/(((\s+at\s+)[^(]*)\(:(\d+)\)\s?)/");
+namespace {
 
-int main(int argc, char** argv) {
-  if (argc < 2) {
-    std::cerr << "Usage: cat trace | remap mapping_file\n";
-    abort();
+const boost::regex trace_regex(R"/(((\s+at\s+)[^(]*)\(:(\d+)\)\s?)/");
+
+// With several jobs, the input is read in batches of BATCH_LINES lines, and
+// each job symbolicates CHUNK_LINES lines at a time.
+constexpr size_t BATCH_LINES = 1 << 16;
+constexpr size_t CHUNK_LINES = 1 << 10;
+
+void print_usage() {
+  std::cerr << "Usage: cat trace | symbolicate-trace [-j <jobs>] mapping_file\n"
+               "  -j, --jobs <jobs>  symbolicate batches of lines on <jobs> "
+               "threads instead\n"
+               "                     of streaming the input line by line\n";
+}
+
+void symbolicate(const MappedPositionMap& map,
+                 const std::string& line,
+                 std::string* out) {
+  boost::smatch matches;
+  if (boost::regex_match(line, matches, trace_regex)) {
+    auto idx = std::stoi(matches[3]) - 1;
+    auto stack = get_stack(map, idx);
+    for (const auto& pos : stack) {
+      out->append(matches[2].first, matches[2].second);
+      out->append(pos.cls).append(".").append(pos.method).append("(");
+      out->append(pos.filename).append(":");
+      out->append(std::to_string(pos.line)).append(")\n");
+    }
+  } else {
+    out->append(line).append("\n");
   }
-  auto map = read_map(argv[1]);
-  for (std::string line; std::getline(std::cin, line);) {
-    boost::smatch matches;
-    if (boost::regex_match(line, matches, trace_regex)) {
-      auto idx = std::stoi(matches[3]) - 1;
-      auto stack = get_stack(*map, idx);
-      for (const auto& pos : stack) {
-        std::cout << matches[2] << pos.cls << "." << pos.method << "("
-                  << pos.filename << ":" << pos.line << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t jobs = 1;
+  int c;
+  static const struct option options[] = {
+      {"jobs", required_argument, nullptr, 'j'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0},
+  };
+  while ((c = getopt_long(argc, argv, "hj:", &options[0], nullptr)) != -1) {
+    switch (c) {
+    case 'j':
+      jobs = parse_dump_jobs(optarg);
+      if (jobs == 0) {
+        std::cerr << argv[0] << ": invalid number of jobs " << optarg << "\n";
+        return 1;
       }
-    } else {
-      std::cout << line << std::endl;
+      break;
+    case 'h':
+      print_usage();
+      return 0;
+    default:
+      print_usage();
+      return 1;
+    }
+  }
+  if (optind == argc) {
+    print_usage();
+    return 1;
+  }
+
+  auto map = MappedPositionMap::open(argv[optind]);
+  if (map == nullptr) {
+    return 1;
+  }
+
+  if (jobs == 1) {
+    std::string out;
+    for (std::string line; std::getline(std::cin, line);) {
+      out.clear();
+      symbolicate(*map, line, &out);
+      fwrite(out.data(), 1, out.size(), stdout);
+      fflush(stdout);
+    }
+    return 0;
+  }
+
+  std::vector<std::string> lines;
+  while (true) {
+    lines.clear();
+    for (std::string line;
+         lines.size() < BATCH_LINES && std::getline(std::cin, line);) {
+      lines.push_back(std::move(line));
+    }
+    if (lines.empty()) {
+      break;
     }
+    size_t chunks = (lines.size() + CHUNK_LINES - 1) / CHUNK_LINES;
+    parallel_dump(
+        chunks,
+        jobs,
+        [&](size_t chunk) {
+          std::string out;
+          auto end = std::min(lines.size(), (chunk + 1) * CHUNK_LINES);
+          for (size_t i = chunk * CHUNK_LINES; i < end; ++i) {
+            symbolicate(*map, lines[i], &out);
+          }
+          return out;
+        },
+        stdout);
   }
+  return 0;
 }
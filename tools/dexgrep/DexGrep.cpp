@@ -7,26 +7,57 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <getopt.h> // @donotremove
 #include <regex>
+#include <string>
 
 #include "DexCommon.h"
+#include "ParallelDump.h"
 
 void print_usage() {
-  fprintf(stderr, "Usage: dexgrep <classname> <dexfile 1> <dexfile 2> ...\n");
+  fprintf(stderr,
+          "Usage: dexgrep [-l] [-F] [-j <jobs>] <classname> <dexfile 1> "
+          "<dexfile 2> ...\n");
 }
 
+namespace {
+
+// Whether a pattern matches exactly the same strings as a search for the
+// pattern text itself, i.e., it contains no regex metacharacters.
+bool is_literal(const char* pattern) {
+  return strpbrk(pattern, "\\^$.|?*+()[]{}") == nullptr;
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
   bool files_only = false;
+  bool fixed_strings = false;
+  size_t jobs = default_dump_jobs();
   int c;
   static const struct option options[] = {
-      {"files-without-match", no_argument, nullptr, 'l'},
+      {"files-with-matches", no_argument, nullptr, 'l'},
+      {"fixed-strings", no_argument, nullptr, 'F'},
+      {"jobs", required_argument, nullptr, 'j'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0},
   };
-  while ((c = getopt_long(argc, argv, "hl", &options[0], nullptr)) != -1) {
+  while ((c = getopt_long(argc, argv, "hlFj:", &options[0], nullptr)) != -1) {
     switch (c) {
     case 'l':
       files_only = true;
       break;
+    case 'F':
+      fixed_strings = true;
+      break;
+    case 'j':
+      jobs = parse_dump_jobs(optarg);
+      if (jobs == 0) {
+        fprintf(stderr, "%s: invalid number of jobs %s\n", argv[0], optarg);
+        return 1;
+      }
+      break;
     case 'h':
       print_usage();
       return 0;
@@ -43,24 +74,44 @@ int main(int argc, char* argv[]) {
   }
 
   const char* search_str = argv[optind];
-  std::regex re(search_str);
+  // Most searches are for (parts of) class names, which we can match with a
+  // plain substring search instead of running the regex engine.
+  bool literal = fixed_strings || is_literal(search_str);
+  std::regex re;
+  if (!literal) {
+    re = std::regex(search_str, std::regex::optimize);
+  }
+  auto matches = [&](const char* name) {
+    return literal ? strstr(name, search_str) != nullptr
+                   : std::regex_search(name, re);
+  };
 
-  for (int i = optind + 1; i < argc; ++i) {
-    const char* dexfile = argv[i];
-    ddump_data rd;
-    open_dex_file(dexfile, &rd);
+  // The dex files are scanned in parallel; the matches are printed in the
+  // order of the given files.
+  size_t count = argc - optind - 1;
+  parallel_dump(
+      count, jobs,
+      [&](size_t i) {
+        const char* dexfile = argv[optind + 1 + i];
+        ddump_data rd;
+        open_dex_file(dexfile, &rd);
 
-    auto size = rd.dexh->class_defs_size;
-    for (uint32_t j = 0; j < size; j++) {
-      dex_class_def* cls_def = rd.dex_class_defs + j;
-      char* name = dex_string_by_type_idx(&rd, cls_def->typeidx);
-      if (std::regex_search(name, re)) {
-        if (files_only) {
-          printf("%s\n", dexfile);
-        } else {
-          printf("%s: %s\n", dexfile, name);
+        std::string output;
+        auto size = rd.dexh->class_defs_size;
+        for (uint32_t j = 0; j < size; j++) {
+          dex_class_def* cls_def = rd.dex_class_defs + j;
+          char* name = dex_string_by_type_idx(&rd, cls_def->typeidx);
+          if (!matches(name)) {
+            continue;
+          }
+          output.append(dexfile);
+          if (files_only) {
+            output.append("\n");
+            break;
+          }
+          output.append(": ").append(name).append("\n");
         }
-      }
-    }
-  }
+        return output;
+      },
+      stdout);
 }
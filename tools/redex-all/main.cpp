@@ -127,6 +127,7 @@ struct Arguments {
   std::optional<std::string> assert_abort;
   std::optional<std::string> crash_file;
   bool chrome_trace{false};
+  std::optional<uint64_t> chrome_trace_work_item_threshold_us;
 };
 
 DEBUG_ONLY void dump_args(const Arguments& args) {
@@ -507,6 +508,10 @@ Arguments parse_args(int argc, char* argv[]) {
       "Write a Chrome Trace Event JSON file (redex-chrome-trace.json) to the "
       "meta output directory for visualization in Perfetto or "
       "chrome://tracing.");
+  od.add_options()(
+      "chrome-trace-work-item-threshold-us", po::value<uint64_t>(),
+      "With --chrome-trace, also record individual work items of parallel "
+      "walks and work queues that take at least this many microseconds.");
 
   // For testing purposes.
   od.add_options()("assert-abort", po::value<std::string>(),
@@ -545,6 +550,11 @@ Arguments parse_args(int argc, char* argv[]) {
     args.chrome_trace = true;
   }
 
+  if (vm.count("chrome-trace-work-item-threshold-us") != 0u) {
+    args.chrome_trace_work_item_threshold_us =
+        vm["chrome-trace-work-item-threshold-us"].as<uint64_t>();
+  }
+
   if (vm.count("assert-abort") != 0u) {
     CrashFile crash_file;
     if (args.crash_file) {
@@ -2155,6 +2165,10 @@ int main(int argc, char* argv[]) {
 
     if (args.chrome_trace) {
       chrome_trace_enabled = true;
+      if (args.chrome_trace_work_item_threshold_us) {
+        ChromeTraceWriter::set_work_item_threshold(std::chrono::microseconds(
+            *args.chrome_trace_work_item_threshold_us));
+      }
     } else {
       ChromeTraceWriter::disable();
     }
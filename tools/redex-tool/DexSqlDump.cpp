@@ -34,6 +34,7 @@ $ ./native/redex/tools/redex-tool/DexSqlQuery.py dex.db
 #include "Resolver.h"
 #include "Show.h"
 #include "Tool.h"
+#include "WorkQueue.h"
 
 namespace {
 
@@ -42,99 +43,173 @@ static std::unordered_map<DexMethod*, int> method_ids;
 static std::unordered_map<DexField*, int> field_ids;
 static std::unordered_map<const DexString*, int> string_ids;
 
-void dump_field_refs(FILE* fdout,
-                     const char* prefix,
-                     DexField* field,
-                     int field_id) {
-  static int next_string_ref = 0;
+// sqlite3 versions before 3.8.8 limit the number of rows of a VALUES clause.
+constexpr size_t MAX_ROWS_PER_INSERT = 500;
+
+// Writes the rows of a table as multi-row INSERT statements, which are both
+// much shorter and much faster for sqlite3 to import than one statement per
+// row.
+class TableWriter {
+ public:
+  TableWriter(FILE* fdout, const char* prefix, const char* table)
+      : m_fdout(fdout), m_table(std::string(prefix) + table) {}
+
+  TableWriter(const TableWriter&) = delete;
+  TableWriter& operator=(const TableWriter&) = delete;
+
+  ~TableWriter() { flush(); }
+
+  // Appends a row, given as a comma-separated list of values.
+  void add_row(const std::string& values) {
+    if (m_rows == 0) {
+      fprintf(m_fdout, "INSERT INTO %s VALUES\n(%s)", m_table.c_str(),
+              values.c_str());
+    } else {
+      fprintf(m_fdout, ",\n(%s)", values.c_str());
+    }
+    if (++m_rows == MAX_ROWS_PER_INSERT) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (m_rows > 0) {
+      fprintf(m_fdout, ";\n");
+      m_rows = 0;
+    }
+  }
+
+ private:
+  FILE* m_fdout;
+  std::string m_table;
+  size_t m_rows{0};
+};
+
+// Quotes a string for SQL, escaping ' as ''.
+std::string quote(const char* str) {
+  std::string esc(str == nullptr ? "" : str);
+  boost::replace_all(esc, "'", "''");
+  return "'" + esc + "'";
+}
+
+// A reference from a method or field to a string, class, field or method,
+// together with the opcode of the referencing instruction for methods.
+struct Ref {
+  int id;
+  int ref_id;
+  int opcode;
+};
+
+// The references of the members of one class, in the order in which they
+// are dumped. They are gathered in parallel for all classes, and dumped in
+// class order so that the row ids don't depend on the scheduling.
+struct ClassRefs {
+  std::vector<Ref> field_string_refs;
+  std::vector<Ref> method_string_refs;
+  std::vector<Ref> method_class_refs;
+  std::vector<Ref> method_field_refs;
+  std::vector<Ref> method_method_refs;
+};
+
+template <class Member>
+int get_id(const std::unordered_map<Member*, int>& ids, Member* member) {
+  auto it = ids.find(member);
+  return it == ids.end() ? -1 : it->second;
+}
+
+void gather_field_refs(DexField* field, int field_id, ClassRefs* refs) {
   auto* static_value = field->get_static_value();
   if ((static_value == nullptr) || (static_value->evtype() != DEVT_STRING)) {
     return;
   }
   auto* static_string_value =
       dynamic_cast<DexEncodedValueString*>(static_value);
-  auto string_id = string_ids[static_string_value->string()];
-  fprintf(fdout,
-          "INSERT INTO %sfield_string_refs VALUES (%d, %d, %d);\n",
-          prefix,
-          next_string_ref++,
-          field_id,
-          string_id);
+  auto it = string_ids.find(static_string_value->string());
+  // Strings that are not emitted in any dex are attributed to string 0.
+  auto string_id = it == string_ids.end() ? 0 : it->second;
+  refs->field_string_refs.push_back({field_id, string_id, 0});
 }
 
-void dump_method_refs(FILE* fdout,
-                      const char* prefix,
-                      DexMethod* method,
-                      int method_id) {
+void gather_method_refs(DexMethod* method, int method_id, ClassRefs* refs) {
   auto* code = method->get_code();
   if (code == nullptr) {
     return;
   }
 
-  static int next_string_ref = 0;
-  static int next_class_ref = 0;
-  static int next_field_ref = 0;
-  static int next_method_ref = 0;
-
   for (auto& mie : InstructionIterable(code)) {
     auto* insn = mie.insn;
+    int opcode = insn->opcode();
     if (insn->has_string()) {
-      if (string_ids.count(insn->get_string()) != 0u) {
-        auto string_id = string_ids[insn->get_string()];
-        fprintf(fdout,
-                "INSERT INTO %smethod_string_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_string_ref++,
-                method_id,
-                string_id,
-                insn->opcode());
+      auto it = string_ids.find(insn->get_string());
+      if (it != string_ids.end()) {
+        refs->method_string_refs.push_back({method_id, it->second, opcode});
       }
     }
     if (insn->has_type()) {
       auto* cls = type_class(insn->get_type());
-      if ((cls != nullptr) && (class_ids.count(cls) != 0u)) {
-        auto class_id = class_ids[cls];
-        fprintf(fdout,
-                "INSERT INTO %smethod_class_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_class_ref++,
-                method_id,
-                class_id,
-                insn->opcode());
+      if (cls != nullptr) {
+        auto class_id = get_id(class_ids, cls);
+        if (class_id != -1) {
+          refs->method_class_refs.push_back({method_id, class_id, opcode});
+        }
       }
     }
     if (insn->has_field()) {
       auto* field = resolve_field(insn->get_field());
-      if (field != nullptr && (field_ids.count(field) != 0u)) {
-        auto field_id = field_ids[field];
-        fprintf(fdout,
-                "INSERT INTO %smethod_field_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_field_ref++,
-                method_id,
-                field_id,
-                insn->opcode());
+      if (field != nullptr) {
+        auto field_id = get_id(field_ids, field);
+        if (field_id != -1) {
+          refs->method_field_refs.push_back({method_id, field_id, opcode});
+        }
       }
     }
     if (insn->has_method()) {
       auto* meth = resolve_method_deprecated(
           insn->get_method(), opcode_to_search(insn), method);
-      if (meth != nullptr && (method_ids.count(meth) != 0u)) {
-        auto method_ref_id = method_ids[meth];
-        fprintf(fdout,
-                "INSERT INTO %smethod_method_refs VALUES (%d, %d, %d, %d);\n",
-                prefix,
-                next_method_ref++,
-                method_id,
-                method_ref_id,
-                insn->opcode());
+      if (meth != nullptr) {
+        auto method_ref_id = get_id(method_ids, meth);
+        if (method_ref_id != -1) {
+          refs->method_method_refs.push_back(
+              {method_id, method_ref_id, opcode});
+        }
       }
     }
   }
 }
 
-void dump_class(FILE* fdout,
-                const char* prefix,
+ClassRefs gather_class_refs(DexClass* cls) {
+  ClassRefs refs;
+  for (const auto& meth : cls->get_dmethods()) {
+    gather_method_refs(meth, method_ids.at(meth), &refs);
+  }
+  for (auto& meth : cls->get_vmethods()) {
+    gather_method_refs(meth, method_ids.at(meth), &refs);
+  }
+  for (const auto& field : cls->get_sfields()) {
+    gather_field_refs(field, field_ids.at(field), &refs);
+  }
+  for (const auto& field : cls->get_ifields()) {
+    gather_field_refs(field, field_ids.at(field), &refs);
+  }
+  return refs;
+}
+
+void dump_refs(TableWriter& writer,
+               const std::vector<Ref>& refs,
+               bool with_opcode,
+               int& next_ref_id) {
+  for (const auto& ref : refs) {
+    std::string row = std::to_string(next_ref_id++) + "," +
+                      std::to_string(ref.id) + "," +
+                      std::to_string(ref.ref_id);
+    if (with_opcode) {
+      row += "," + std::to_string(ref.opcode);
+    }
+    writer.add_row(row);
+  }
+}
+
+void dump_class(TableWriter& writer,
                 const char* dex_id,
                 DexClass* cls,
                 int class_id) {
@@ -143,18 +218,13 @@ void dump_class(FILE* fdout,
   // TODO: string usage
   // TODO: size estimate
   const auto& deobfuscated_name = cls->get_deobfuscated_name();
-  fprintf(fdout,
-          "INSERT INTO %sclasses VALUES (%d,'%s','%s','%s',%u);\n",
-          prefix,
-          class_id,
-          dex_id,
-          deobfuscated_name.c_str(),
-          cls->get_name()->c_str(),
-          cls->get_access());
+  writer.add_row(std::to_string(class_id) + "," + quote(dex_id) + "," +
+                 quote(deobfuscated_name.c_str()) + "," +
+                 quote(cls->get_name()->c_str()) + "," +
+                 std::to_string(cls->get_access()));
 }
 
-void dump_field(FILE* fdout,
-                const char* prefix,
+void dump_field(TableWriter& writer,
                 int class_id,
                 DexField* field,
                 int field_id) {
@@ -162,20 +232,15 @@ void dump_field(FILE* fdout,
   // TODO: break down signature
   // TODO: annotations?
   // TODO: string usage (encoded_value for static fields)
-  const auto& deobfuscated_name = field->get_deobfuscated_name();
+  const auto deobfuscated_name = field->get_deobfuscated_name_or_empty_copy();
   const auto* field_name = strchr(deobfuscated_name.c_str(), ';');
-  fprintf(fdout,
-          "INSERT INTO %sfields VALUES(%d, %d, '%s', '%s', %u);\n",
-          prefix,
-          field_id,
-          class_id,
-          field_name,
-          field->get_name()->c_str(),
-          field->get_access());
+  writer.add_row(std::to_string(field_id) + "," + std::to_string(class_id) +
+                 "," + quote(field_name) + "," +
+                 quote(field->get_name()->c_str()) + "," +
+                 std::to_string(field->get_access()));
 }
 
-void dump_method(FILE* fdout,
-                 const char* prefix,
+void dump_method(TableWriter& writer,
                  int class_id,
                  DexMethod* method,
                  int method_id) {
@@ -187,16 +252,13 @@ void dump_method(FILE* fdout,
   // TODO: size estimate
   const auto& deobfuscated_name = method->get_deobfuscated_name();
   const auto* method_name = strchr(deobfuscated_name.c_str(), ';');
-  fprintf(fdout,
-          "INSERT INTO %smethods VALUES (%d,%d,'%s','%s',%d,%zu);\n",
-          prefix,
-          method_id,
-          class_id,
-          method_name,
-          method->get_name()->c_str(),
-          method->get_access(),
-          method->get_code() != nullptr ? method->get_code()->sum_opcode_sizes()
-                                        : 0);
+  writer.add_row(
+      std::to_string(method_id) + "," + std::to_string(class_id) + "," +
+      quote(method_name) + "," + quote(method->get_name()->c_str()) + "," +
+      std::to_string(method->get_access()) + "," +
+      std::to_string(method->get_code() != nullptr
+                         ? method->get_code()->sum_opcode_sizes()
+                         : 0));
 }
 
 void dump_sql(FILE* fdout,
@@ -283,82 +345,90 @@ CREATE TABLE %1$smethod_string_refs (
   int next_string_id = 0;
 
   // Dump all dex items
+  std::vector<DexClass*> classes;
   fprintf(fdout, "BEGIN TRANSACTION;\n");
-  for (auto& store : stores) {
-    auto store_name = store.get_name();
-    auto& dexen = store.get_dexen();
-    apply_deobfuscated_names(dexen, pg_map);
-    for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
-      auto& dex = dexen[dex_idx];
-      GatheredTypes gtypes(&dex);
-      auto strings = gtypes.get_cls_order_dexstring_emitlist();
-      for (const auto* dexstr : strings) {
-        int id = next_string_id++;
-        string_ids[dexstr] = id;
-        // Escape string before inserting. ' -> ''
-        std::string esc(dexstr->c_str());
-        boost::replace_all(esc, "'", "''");
-        fprintf(fdout,
-                "INSERT INTO %sstrings VALUES(%d, '%s');\n",
-                prefix,
-                id,
-                esc.c_str());
-      }
-      std::string dex_id_str(store_name + "/" + std::to_string(dex_idx));
-      const char* dex_id = dex_id_str.c_str();
-      for (const auto& cls : dex) {
-        int class_id = next_class_id++;
-        dump_class(fdout, prefix, dex_id, cls, class_id);
-        class_ids[cls] = class_id;
-        for (auto* field : cls->get_ifields()) {
-          int field_id = next_field_id++;
-          field_ids[field] = field_id;
-          dump_field(fdout, prefix, class_id, field, field_id);
-        }
-        for (auto* field : cls->get_sfields()) {
-          int field_id = next_field_id++;
-          field_ids[field] = field_id;
-          dump_field(fdout, prefix, class_id, field, field_id);
-        }
-        for (const auto& meth : cls->get_dmethods()) {
-          int meth_id = next_method_id++;
-          method_ids[meth] = meth_id;
-          dump_method(fdout, prefix, class_id, meth, meth_id);
+  {
+    TableWriter strings_writer(fdout, prefix, "strings");
+    TableWriter classes_writer(fdout, prefix, "classes");
+    TableWriter fields_writer(fdout, prefix, "fields");
+    TableWriter methods_writer(fdout, prefix, "methods");
+    for (auto& store : stores) {
+      auto store_name = store.get_name();
+      auto& dexen = store.get_dexen();
+      apply_deobfuscated_names(dexen, pg_map);
+      for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
+        auto& dex = dexen[dex_idx];
+        GatheredTypes gtypes(&dex);
+        auto strings = gtypes.get_cls_order_dexstring_emitlist();
+        for (const auto* dexstr : strings) {
+          int id = next_string_id++;
+          string_ids[dexstr] = id;
+          strings_writer.add_row(std::to_string(id) + "," +
+                                 quote(dexstr->c_str()));
         }
-        for (auto& meth : cls->get_vmethods()) {
-          int meth_id = next_method_id++;
-          method_ids[meth] = meth_id;
-          dump_method(fdout, prefix, class_id, meth, meth_id);
+        std::string dex_id_str(store_name + "/" + std::to_string(dex_idx));
+        const char* dex_id = dex_id_str.c_str();
+        for (const auto& cls : dex) {
+          int class_id = next_class_id++;
+          dump_class(classes_writer, dex_id, cls, class_id);
+          class_ids[cls] = class_id;
+          classes.push_back(cls);
+          for (auto* field : cls->get_ifields()) {
+            int field_id = next_field_id++;
+            field_ids[field] = field_id;
+            dump_field(fields_writer, class_id, field, field_id);
+          }
+          for (auto* field : cls->get_sfields()) {
+            int field_id = next_field_id++;
+            field_ids[field] = field_id;
+            dump_field(fields_writer, class_id, field, field_id);
+          }
+          for (const auto& meth : cls->get_dmethods()) {
+            int meth_id = next_method_id++;
+            method_ids[meth] = meth_id;
+            dump_method(methods_writer, class_id, meth, meth_id);
+          }
+          for (auto& meth : cls->get_vmethods()) {
+            int meth_id = next_method_id++;
+            method_ids[meth] = meth_id;
+            dump_method(methods_writer, class_id, meth, meth_id);
+          }
         }
       }
     }
   }
   fprintf(fdout, "END TRANSACTION;\n");
 
-  // Dump references
+  // Dump references. Resolving the references of all instructions dominates
+  // the running time, so we gather them for all classes in parallel; the id
+  // maps are only read from here on.
+  std::vector<ClassRefs> class_refs(classes.size());
+  workqueue_run_for<size_t>(0, classes.size(), [&](size_t i) {
+    class_refs[i] = gather_class_refs(classes[i]);
+  });
   fprintf(fdout, "BEGIN TRANSACTION;\n");
-  for (auto& store : stores) {
-    auto& dexen = store.get_dexen();
-    for (size_t dex_idx = 0; dex_idx < dexen.size(); ++dex_idx) {
-      auto& dex = dexen[dex_idx];
-      for (const auto& cls : dex) {
-        for (const auto& meth : cls->get_dmethods()) {
-          int meth_id = method_ids[meth];
-          dump_method_refs(fdout, prefix, meth, meth_id);
-        }
-        for (auto& meth : cls->get_vmethods()) {
-          int meth_id = method_ids[meth];
-          dump_method_refs(fdout, prefix, meth, meth_id);
-        }
-        for (const auto& field : cls->get_sfields()) {
-          int field_id = field_ids[field];
-          dump_field_refs(fdout, prefix, field, field_id);
-        }
-        for (const auto& field : cls->get_ifields()) {
-          int field_id = field_ids[field];
-          dump_field_refs(fdout, prefix, field, field_id);
-        }
-      }
+  {
+    TableWriter field_string_refs_writer(fdout, prefix, "field_string_refs");
+    TableWriter method_string_refs_writer(fdout, prefix, "method_string_refs");
+    TableWriter method_class_refs_writer(fdout, prefix, "method_class_refs");
+    TableWriter method_field_refs_writer(fdout, prefix, "method_field_refs");
+    TableWriter method_method_refs_writer(fdout, prefix, "method_method_refs");
+    int next_field_string_ref = 0;
+    int next_method_string_ref = 0;
+    int next_method_class_ref = 0;
+    int next_method_field_ref = 0;
+    int next_method_method_ref = 0;
+    for (const auto& refs : class_refs) {
+      dump_refs(field_string_refs_writer, refs.field_string_refs,
+                /* with_opcode */ false, next_field_string_ref);
+      dump_refs(method_string_refs_writer, refs.method_string_refs,
+                /* with_opcode */ true, next_method_string_ref);
+      dump_refs(method_class_refs_writer, refs.method_class_refs,
+                /* with_opcode */ true, next_method_class_ref);
+      dump_refs(method_field_refs_writer, refs.method_field_refs,
+                /* with_opcode */ true, next_method_field_ref);
+      dump_refs(method_method_refs_writer, refs.method_method_refs,
+                /* with_opcode */ true, next_method_method_ref);
     }
   }
   fprintf(fdout, "END TRANSACTION;\n");
@@ -368,18 +438,18 @@ CREATE TABLE %1$smethod_string_refs (
   ClassHierarchy ch = build_type_hierarchy(scope);
   int next_is_a_id = 0;
   fprintf(fdout, "BEGIN TRANSACTION;\n");
-  for (auto& cls : scope) {
-    TypeSet results;
-    get_all_children_or_implementors(ch, scope, cls, results);
-    for (const auto* type : results) {
-      auto* type_cls = type_class(type);
-      if (type_cls != nullptr) {
-        fprintf(fdout,
-                "INSERT INTO %sis_a VALUES(%d, %d, %d);\n",
-                prefix,
-                next_is_a_id++,
-                class_ids[type_cls],
-                class_ids[cls]);
+  {
+    TableWriter is_a_writer(fdout, prefix, "is_a");
+    for (auto& cls : scope) {
+      TypeSet results;
+      get_all_children_or_implementors(ch, scope, cls, results);
+      for (const auto* type : results) {
+        auto* type_cls = type_class(type);
+        if (type_cls != nullptr) {
+          is_a_writer.add_row(std::to_string(next_is_a_id++) + "," +
+                              std::to_string(class_ids[type_cls]) + "," +
+                              std::to_string(class_ids[cls]));
+        }
       }
     }
   }
@@ -7,16 +7,26 @@
 
 #include "PrintUtil.h"
 #include <cstdarg>
+#include <cstdlib>
 #include <stdio.h>
 
 bool clean = false;
 bool raw = false;
 bool escape = false;
 
+namespace {
+
+// Where redump prints on the current thread, stdout if null.
+thread_local FILE* redump_file = nullptr;
+
+FILE* out() { return redump_file != nullptr ? redump_file : stdout; }
+
+} // namespace
+
 void redump(const char* format, ...) {
   va_list va;
   va_start(va, format);
-  vprintf(format, va);
+  vfprintf(out(), format, va);
   va_end(va);
 }
 
@@ -24,9 +34,9 @@ void redump(uint32_t off, const char* format, ...) {
   va_list va;
   va_start(va, format);
   if (!clean) {
-    printf("[0x%x] ", off);
+    fprintf(out(), "[0x%x] ", off);
   }
-  vprintf(format, va);
+  vfprintf(out(), format, va);
   va_end(va);
 }
 
@@ -34,8 +44,32 @@ void redump(uint32_t pos, uint32_t off, const char* format, ...) {
   va_list va;
   va_start(va, format);
   if (!clean) {
-    printf("(0x%x) [0x%x] ", pos, off);
+    fprintf(out(), "(0x%x) [0x%x] ", pos, off);
   }
-  vprintf(format, va);
+  vfprintf(out(), format, va);
   va_end(va);
 }
+
+RedumpCapture::RedumpCapture() : m_previous(redump_file) {
+  m_file = open_memstream(&m_buffer, &m_size);
+  if (m_file == nullptr) {
+    fprintf(stderr, "Cannot allocate output buffer, bailing\n");
+    exit(1);
+  }
+  redump_file = m_file;
+}
+
+RedumpCapture::~RedumpCapture() { release(); }
+
+std::string RedumpCapture::release() {
+  if (m_file == nullptr) {
+    return std::string();
+  }
+  fclose(m_file);
+  m_file = nullptr;
+  redump_file = m_previous;
+  std::string result(m_buffer, m_size);
+  free(m_buffer);
+  m_buffer = nullptr;
+  return result;
+}
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
+#include <string>
 
 extern bool clean;
 extern bool raw;
@@ -16,3 +18,23 @@ extern bool escape;
 void redump(const char* format, ...);
 void redump(uint32_t off, const char* format, ...);
 void redump(uint32_t pos, uint32_t off, const char* format, ...);
+
+// Redirects everything printed by redump on the current thread into a string,
+// so that several dex files can be dumped concurrently.
+class RedumpCapture {
+ public:
+  RedumpCapture();
+  ~RedumpCapture();
+
+  RedumpCapture(const RedumpCapture&) = delete;
+  RedumpCapture& operator=(const RedumpCapture&) = delete;
+
+  // Stops capturing and returns the captured output.
+  std::string release();
+
+ private:
+  FILE* m_file{nullptr};
+  FILE* m_previous{nullptr};
+  char* m_buffer{nullptr};
+  size_t m_size{0};
+};
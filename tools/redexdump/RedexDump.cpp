@@ -11,6 +11,7 @@
 #include <stdlib.h>
 
 #include "Formatters.h"
+#include "ParallelDump.h"
 #include "PrintUtil.h"
 
 static const char ddump_usage_string[] =
@@ -46,7 +47,9 @@ static const char ddump_usage_string[] =
     "printing options:\n"
     "--clean: suppress indices and offsets\n"
     "--no-headers: suppress headers\n"
-    "--raw: print all bytes, even control characters\n";
+    "--raw: print all bytes, even control characters\n"
+    "-j, --jobs=<n>: dump up to <n> dex files concurrently; the output is "
+    "still in the order of the given files\n";
 
 int main(int argc, char* argv[]) {
 
@@ -67,6 +70,7 @@ int main(int argc, char* argv[]) {
   bool redexdump_debug = false;
   uint32_t ddebug_offset = 0;
   int no_headers = 0;
+  size_t jobs = default_dump_jobs();
 
   char c;
   static const struct option options[] = {
@@ -90,11 +94,12 @@ int main(int argc, char* argv[]) {
       {"raw", no_argument, (int*)&raw, 1},
       {"escape", no_argument, (int*)&escape, 1},
       {"no-headers", no_argument, &no_headers, 1},
+      {"jobs", required_argument, nullptr, 'j'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, 0, nullptr, 0},
   };
 
-  while ((c = getopt_long(argc, argv, "asStpfmcCxeAdD:h", &options[0],
+  while ((c = getopt_long(argc, argv, "asStpfmcCxeAdD:j:h", &options[0],
                           nullptr)) != -1) {
     switch (c) {
     case 'a':
@@ -145,6 +150,13 @@ int main(int argc, char* argv[]) {
     case 'D':
       sscanf(optarg, "%x", &ddebug_offset);
       break;
+    case 'j':
+      jobs = parse_dump_jobs(optarg);
+      if (jobs == 0) {
+        fprintf(stderr, "%s: invalid number of jobs %s\n", argv[0], optarg);
+        return 1;
+      }
+      break;
     case 'h':
       puts(ddump_usage_string);
       return 0;
@@ -163,8 +175,7 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  while (optind < argc) {
-    const char* dexfile = argv[optind++];
+  auto dump_file = [&](const char* dexfile) {
     ddump_data rd;
     open_dex_file(dexfile, &rd);
     if (no_headers == 0) {
@@ -216,8 +227,25 @@ int main(int argc, char* argv[]) {
     if (ddebug_offset != 0) {
       disassemble_debug(&rd, ddebug_offset);
     }
-    fprintf(stdout, "\n");
-    fflush(stdout);
+    redump("\n");
+  };
+
+  size_t count = argc - optind;
+  if (jobs <= 1 || count == 1) {
+    // Print directly, without buffering the output of whole files.
+    for (size_t i = 0; i < count; ++i) {
+      dump_file(argv[optind + i]);
+      fflush(stdout);
+    }
+  } else {
+    parallel_dump(
+        count, jobs,
+        [&](size_t i) {
+          RedumpCapture capture;
+          dump_file(argv[optind + i]);
+          return capture.release();
+        },
+        stdout);
   }
 
   return 0;